@@ -1,22 +1,46 @@
 #include "Algorithm.h"
 
 namespace WritingMaterialsManager {
+    char32_t CaseFolding::FoldSlow(const char32_t c) noexcept { return QChar::toCaseFolded(c); }
+// ----------------------------------------------------------------
+
+    // The strings are folded chunk by chunk into a small buffer and fed to the hash incrementally, so no folded copy of the whole string is materialized.
     size_t CaseInsensitiveHasher::operator()(const QByteArray& Str) const noexcept {
-        return *reinterpret_cast<const size_t*>(QCryptographicHash::hash(Str.toUpper(), DefaultHashAlgorithm).right(sizeof(size_t)).constData());
+        QCryptographicHash Hash(DefaultHashAlgorithm);
+        char Buffer[256];
+        for (qsizetype i = 0; i < Str.size(); i += sizeof(Buffer)) {
+            const qsizetype n = std::min<qsizetype>(sizeof(Buffer), Str.size() - i);
+            std::transform(Str.constData() + i, Str.constData() + i + n, Buffer, [](const char c) {
+                return static_cast<unsigned char>(c) - 'A' < 26u ? static_cast<char>(c + ('a' - 'A')) : c; // ASCII letters are folded to lower case, the same as QByteArray::toLower()
+            });
+            Hash.addData(QByteArrayView(Buffer, n));
+        }
+        return *reinterpret_cast<const size_t*>(Hash.result().right(sizeof(size_t)).constData());
     }
     size_t CaseInsensitiveHasher::operator()(const QString& Str) const noexcept {
-        const QString STR = Str.toUpper();
-        const QByteArrayView v(reinterpret_cast<const char*>(STR.constData()), STR.size() * 2);
-        return *reinterpret_cast<const size_t*>(QCryptographicHash::hash(v, DefaultHashAlgorithm).right(sizeof(size_t)).constData());
+        return this->operator()(QStringView(Str));
     }
     size_t CaseInsensitiveHasher::operator()(const QAnyStringView Str) const noexcept {
-        if (Str.size_bytes() / Str.size() == 1) { return this->operator()(QByteArray::fromRawData(static_cast<const char*>(Str.data()), Str.size_bytes())); }
-        else { return this->operator()(QString::fromRawData(static_cast<const QChar*>(Str.data()), Str.size_bytes())); } // NOTE: fromRawData doesn't make a deep copy
+        if (Str.size() == 0 || Str.size_bytes() == Str.size()) { return this->operator()(QByteArray::fromRawData(static_cast<const char*>(Str.data()), Str.size_bytes())); }
+        else { return this->operator()(QStringView(static_cast<const QChar*>(Str.data()), Str.size())); } // NOTE: views don't make a deep copy
     }
     size_t CaseInsensitiveHasher::operator()(const QStringView Str) const noexcept {
-        const QString STR = QString::fromRawData(Str.constData(), Str.size()).toUpper();
-        const QByteArrayView v(reinterpret_cast<const char*>(STR.constData()), STR.size() * 2);
-        return *reinterpret_cast<const size_t*>(QCryptographicHash::hash(v, DefaultHashAlgorithm).right(sizeof(size_t)).constData());
+        QCryptographicHash Hash(DefaultHashAlgorithm);
+        char16_t Buffer[256];
+        qsizetype n = 0;
+        for (const char32_t c: CaseFolding::View(Str)) {
+            if (n + 2 > static_cast<qsizetype>(std::size(Buffer))) {
+                Hash.addData(QByteArrayView(reinterpret_cast<const char*>(Buffer), n * sizeof(char16_t)));
+                n = 0;
+            }
+            if (QChar::requiresSurrogates(c)) {
+                Buffer[n++] = QChar::highSurrogate(c);
+                Buffer[n++] = QChar::lowSurrogate(c);
+            }
+            else { Buffer[n++] = static_cast<char16_t>(c); }
+        }
+        Hash.addData(QByteArrayView(reinterpret_cast<const char*>(Buffer), n * sizeof(char16_t)));
+        return *reinterpret_cast<const size_t*>(Hash.result().right(sizeof(size_t)).constData());
     }
 // ----------------------------------------------------------------
 
@@ -1,10 +1,120 @@
 #ifndef WRITING_MATERIALS_MANAGER_ALGORITHM_H
 #define WRITING_MATERIALS_MANAGER_ALGORITHM_H
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
 #include <QCryptographicHash>
 #include <QString>
 
 namespace WritingMaterialsManager {
+    /**
+     * Simple (1:1) Unicode case folding, tuned for text which is mostly CJK with some Latin.
+     * Basic Latin, Latin-1, Latin Extended-A and the regular parts of Latin Extended-B, Greek and Cyrillic are folded by a table generated at compile time.
+     * CJK, kana, Hangul and their punctuation are recognized by a few range checks and never folded.
+     * The remaining code points are passed to QChar::toCaseFolded(), which walks the generic Unicode tables of Qt.
+     */
+    struct CaseFolding {
+        static constexpr char32_t TableLimit = 0x0500;  // the table covers [U+0000, TableLimit)
+        static constexpr char16_t Deferred = 0xFFFF;    // table entry: irregular code point, ask Qt
+
+        static constexpr std::array<char16_t, TableLimit> Table = []() consteval {
+            std::array<char16_t, TableLimit> T{};
+            for (char32_t c = 0; c < TableLimit; ++c) { T[c] = static_cast<char16_t>(c); }
+            auto Offset = [&](const char32_t First, const char32_t Last, const int Delta) { for (char32_t c = First; c <= Last; ++c) { T[c] = static_cast<char16_t>(c + Delta); } };
+            auto Pairs = [&](const char32_t First, const char32_t Last) { for (char32_t c = First; c < Last; c += 2) { T[c] = static_cast<char16_t>(c + 1); } }; // upper case at First, lower case right after it
+            auto Defer = [&](const char32_t First, const char32_t Last) { for (char32_t c = First; c <= Last; ++c) { T[c] = Deferred; } };
+
+            Offset(U'A', U'Z', 0x20);                                           // Basic Latin
+            T[0xB5] = 0x3BC; Offset(0xC0, 0xD6, 0x20); Offset(0xD8, 0xDE, 0x20); // Latin-1 Supplement
+            Pairs(0x100, 0x12F); Pairs(0x132, 0x137); Pairs(0x139, 0x148); Pairs(0x14A, 0x177); // Latin Extended-A
+            T[0x178] = 0xFF; Pairs(0x179, 0x17E); T[0x17F] = U's';
+            Defer(0x180, 0x1CC); Pairs(0x1CD, 0x1DC); Pairs(0x1DE, 0x1EF); Defer(0x1F0, 0x1F7); // Latin Extended-B
+            Pairs(0x1F8, 0x21F); Defer(0x220, 0x221); Pairs(0x222, 0x233); Defer(0x234, 0x245); Pairs(0x246, 0x24F);
+            T[0x345] = 0x3B9;                                                   // Combining Diacritical Marks
+            Defer(0x370, 0x3FF); Offset(0x391, 0x3A1, 0x20); Offset(0x3A3, 0x3AB, 0x20); Offset(0x3AC, 0x3C1, 0); Offset(0x3C3, 0x3CE, 0); // Greek
+            Offset(0x400, 0x40F, 0x50); Offset(0x410, 0x42F, 0x20);             // Cyrillic
+            Pairs(0x460, 0x481); Pairs(0x48A, 0x4BF); T[0x4C0] = 0x4CF; Pairs(0x4C1, 0x4CE); Pairs(0x4D0, 0x4FF);
+            return T;
+        }();
+
+        /**
+         * @return Whether the code point is known to have no case folding (CJK, kana, Hangul, Yi, their punctuation, and the supplementary ideographic planes).
+         */
+        static constexpr bool NoFoldingNeeded(const char32_t c) noexcept {
+            return (c - 0x2E80u < 0xA4D0u - 0x2E80u) || (c - 0xAC00u < 0xD7B0u - 0xAC00u) || (c - 0xF900u < 0xFB00u - 0xF900u)
+                || (c - 0xFF00u < 0xFFF0u - 0xFF00u && c - 0xFF21u >= 26u) || (c - 0x20000u < 0x40000u - 0x20000u);
+        }
+        static char32_t Fold(const char32_t c) noexcept {
+            if (c < TableLimit) {
+                const char16_t f = Table[c];
+                return f != Deferred ? f : FoldSlow(c);
+            }
+            if (NoFoldingNeeded(c)) { return c; }
+            if (c - 0xFF21u < 26u) { return c + 0x20; } // fullwidth Latin capital letters
+            return FoldSlow(c);
+        }
+        static char32_t FoldSlow(const char32_t c) noexcept;
+
+        /**
+         * Forward range of the folded code points of a UTF-16 string. Nothing is materialized.
+         * Lone surrogates are passed through unchanged.
+         */
+        class View {
+        public:
+            class Iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = char32_t;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = char32_t;
+
+                Iterator() = default;
+                Iterator(const char16_t* const Current, const char16_t* const End) noexcept : Current(Current), End(End) {}
+
+                char32_t operator*() const noexcept { return Fold(CodePoint()); }
+                Iterator& operator++() noexcept { Current += UnitCount(); return *this; }
+                Iterator operator++(int) noexcept { Iterator i = *this; ++*this; return i; }
+                bool operator==(const Iterator& Other) const noexcept { return Current == Other.Current; }
+
+                size_t UnitCount() const noexcept { return QChar::isHighSurrogate(*Current) && Current + 1 != End && QChar::isLowSurrogate(Current[1]) ? 2 : 1; }
+                char32_t CodePoint() const noexcept { return UnitCount() == 2 ? QChar::surrogateToUcs4(Current[0], Current[1]) : *Current; }
+            private:
+                const char16_t* Current = nullptr;
+                const char16_t* End = nullptr;
+            };
+
+            explicit View(const QStringView Str) noexcept : Str(Str) {}
+
+            Iterator begin() const noexcept { return { Str.utf16(), Str.utf16() + Str.size() }; }
+            Iterator end() const noexcept { return { Str.utf16() + Str.size(), Str.utf16() + Str.size() }; }
+        private:
+            QStringView Str;
+        };
+
+        /**
+         * Case-insensitive equality of 2 UTF-16 strings. Identical code units are not folded.
+         * Simple case folding never changes the length in UTF-16 code units, so strings of different lengths are unequal.
+         */
+        static bool Equal(const QStringView LHS, const QStringView RHS) noexcept {
+            if (LHS.size() != RHS.size()) { return false; }
+            const char16_t* const L = LHS.utf16();
+            const char16_t* const R = RHS.utf16();
+            for (qsizetype i = 0; i < LHS.size();) {
+                if (L[i] == R[i] && QChar::isHighSurrogate(L[i]) == false) { ++i; continue; } // a shared high surrogate may be followed by low surrogates of the same letter in different cases (e.g., Deseret)
+                const View::Iterator I(L + i, L + LHS.size()), J(R + i, R + RHS.size());
+                if (I.UnitCount() != J.UnitCount() || *I != *J) { return false; }
+                i += I.UnitCount();
+            }
+            return true;
+        }
+    };
+
     struct CaseInsensitiveHasher {
         static constexpr auto DefaultHashAlgorithm = QCryptographicHash::Blake2b_160;
         
@@ -46,19 +156,121 @@ namespace WritingMaterialsManager {
         bool operator()(const QAnyStringView LHS, const QAnyStringView RHS) const noexcept; // Qt recommends pass string views by value
         bool operator()(const QUtf8StringView LHS, const QUtf8StringView RHS) const noexcept;
         template<class T = QByteArrayView> typename std::enable_if_t<supported_but_only_member_compare_v<T>, bool> operator()(const T LHS, const T RHS) const noexcept {
-            if constexpr (std::is_class_v<T>) { return LHS.compare(RHS, Qt::CaseInsensitive) == 0; }
+            if constexpr (std::is_same_v<T, QStringView>) { return CaseFolding::Equal(LHS, RHS); } // consistent with CaseInsensitiveHasher
+            else if constexpr (std::is_class_v<T>) { return LHS.compare(RHS, Qt::CaseInsensitive) == 0; }
             else if constexpr (std::is_same_v<std::remove_cvref_t<T>, const char*>) {
                 return QByteArrayView(LHS).compare(QByteArrayView(RHS), Qt::CaseInsensitive) == 0;
             }
             else if constexpr (std::is_same_v<std::remove_cvref_t<T>, const char8_t*>) {
                 return this->operator()(QUtf8StringView(LHS), QUtf8StringView(RHS));
             }
-            else { return QStringView(LHS).compare(QStringView(RHS), Qt::CaseInsensitive) == 0; }
+            else { return CaseFolding::Equal(QStringView(LHS), QStringView(RHS)); }
         }
         template<class T = QByteArray> typename std::enable_if_t<supported_but_should_be_by_ref_v<T>, bool> operator()(const T& LHS, const T& RHS) const noexcept {
-            return LHS.compare(RHS, Qt::CaseInsensitive) == 0;
+            if constexpr (std::is_same_v<T, QString>) { return CaseFolding::Equal(LHS, RHS); }
+            else { return LHS.compare(RHS, Qt::CaseInsensitive) == 0; }
         }
     };
+
+    /**
+     * Perfect hash table of a fixed vocabulary (file types, keywords, etc.), built entirely during constant evaluation.
+     * A lookup costs one hash of the key, one probe and one comparison, and there is no static initialization at run time.
+     * Keys must be ASCII and the vocabulary should be small, because the table has about N^2 slots.
+     * Use MakeStaticStringMap() to construct it so that N is deduced.
+     * @tparam V Type of the mapped values. It must be a literal type.
+     * @tparam N Number of entries.
+     * @tparam CS Whether the keys are compared with or without case sensitivity (ASCII only).
+     */
+    template<class V, size_t N, Qt::CaseSensitivity CS = Qt::CaseInsensitive> class StaticStringMap {
+    public:
+        static_assert(N > 0 && N <= 64, "StaticStringMap is intended for small fixed vocabularies.");
+
+        struct Entry {
+            std::string_view Key;
+            V Value;
+        };
+
+        template<class T> consteval static bool is_ASCII_compatible_key_f() {
+            return CaseInsensitiveHasher::is_UTF_8_compatible_charset_f<T>() || std::is_same_v<T, std::string_view>;
+        }
+        template<class T> consteval static bool is_UTF_16_key_f() {
+            return std::is_same_v<T, QStringView> || std::is_same_v<T, std::u16string_view>
+                || std::is_same_v<std::remove_cvref_t<T>, const char16_t*> || std::is_same_v<std::remove_cvref_t<T>, const QChar*>;
+        }
+        template<class T> struct is_supported_key : std::integral_constant<bool, is_ASCII_compatible_key_f<T>() || is_UTF_16_key_f<T>()> {};
+        template<class T> static constexpr bool is_supported_key_v = is_supported_key<T>::value;
+
+        static constexpr size_t SlotCount = std::bit_ceil(N * N < 4 ? size_t(4) : N * N);
+        static constexpr uint8_t EmptySlot = 0xFF;
+
+        consteval StaticStringMap(const std::pair<std::string_view, V> (&Entries)[N]) {
+            for (size_t i = 0; i < N; ++i) {
+                for (const char c: Entries[i].first) { if (static_cast<unsigned char>(c) > 0x7F) { throw "Keys of StaticStringMap must be ASCII."; } }
+                for (size_t j = 0; j < i; ++j) { if (Equal(Entries[i].first.data(), Entries[i].first.size(), Entries[j].first)) { throw "Duplicate keys in StaticStringMap."; } }
+                this->Entries[i] = { Entries[i].first, Entries[i].second };
+            }
+            for (Seed = 1; Seed < 0x10000; ++Seed) { // search a seed which makes the hash function injective on the given keys
+                Slots.fill(EmptySlot);
+                bool Collided = false;
+                for (size_t i = 0; i < N && Collided == false; ++i) {
+                    uint8_t& Slot = Slots[Hash(this->Entries[i].Key.data(), this->Entries[i].Key.size(), Seed) & (SlotCount - 1)];
+                    if (Slot != EmptySlot) { Collided = true; }
+                    else { Slot = static_cast<uint8_t>(i); }
+                }
+                if (Collided == false) { return; }
+            }
+            throw "No perfect hash seed found for StaticStringMap.";
+        }
+
+        /**
+         * @param Key The key to be looked up. Non-ASCII keys never match.
+         * @return The matched entry, or nullptr if the key is absent.
+         */
+        template<class T> constexpr typename std::enable_if_t<is_supported_key_v<T>, const Entry*> Find(const T Key) const noexcept {
+            if constexpr (std::is_class_v<T>) { return FindImpl(Key.data(), static_cast<size_t>(Key.size())); }
+            else if constexpr (std::is_same_v<std::remove_cvref_t<T>, const QChar*>) { return Find(QStringView(Key)); }
+            else { return FindImpl(Key, std::char_traits<std::remove_cv_t<std::remove_pointer_t<T>>>::length(Key)); }
+        }
+        const Entry* Find(const QByteArray& Key) const noexcept { return FindImpl(Key.constData(), static_cast<size_t>(Key.size())); }
+        const Entry* Find(const QString& Key) const noexcept { return FindImpl(Key.constData(), static_cast<size_t>(Key.size())); }
+        template<class T> constexpr bool Contains(const T& Key) const noexcept { return Find(Key) != nullptr; }
+
+        constexpr const Entry* begin() const noexcept { return Entries.data(); }
+        constexpr const Entry* end() const noexcept { return Entries.data() + N; }
+        constexpr size_t size() const noexcept { return N; }
+    private:
+        std::array<Entry, N> Entries{};
+        std::array<uint8_t, SlotCount> Slots{};
+        uint64_t Seed = 0;
+
+        template<class CharT> constexpr static char32_t Unit(const CharT c) noexcept {
+            if constexpr (std::is_same_v<CharT, QChar>) { return c.unicode(); }
+            else { return static_cast<std::make_unsigned_t<CharT>>(c); }
+        }
+        constexpr static char32_t Fold(const char32_t c) noexcept {
+            if constexpr (CS == Qt::CaseInsensitive) { return c - U'A' < 26 ? c + (U'a' - U'A') : c; }
+            else { return c; }
+        }
+        template<class CharT> constexpr static uint64_t Hash(const CharT* const Str, const size_t Size, const uint64_t Seed) noexcept { // FNV-1a with a seed
+            uint64_t h = 0xCBF29CE484222325ull ^ (Seed * 0x9E3779B97F4A7C15ull);
+            for (size_t i = 0; i < Size; ++i) { h = (h ^ Fold(Unit(Str[i]))) * 0x100000001B3ull; }
+            return h ^ (h >> 32);
+        }
+        template<class CharT> constexpr static bool Equal(const CharT* const Str, const size_t Size, const std::string_view Key) noexcept {
+            if (Size != Key.size()) { return false; }
+            for (size_t i = 0; i < Size; ++i) { if (Fold(Unit(Str[i])) != Fold(Unit(Key[i]))) { return false; } }
+            return true;
+        }
+        template<class CharT> constexpr const Entry* FindImpl(const CharT* const Str, const size_t Size) const noexcept {
+            const uint8_t Slot = Slots[Hash(Str, Size, Seed) & (SlotCount - 1)];
+            if (Slot == EmptySlot) { return nullptr; }
+            return Equal(Str, Size, Entries[Slot].Key) ? &Entries[Slot] : nullptr; // a non-ASCII unit never equals an ASCII one, so it never matches
+        }
+    };
+
+    template<class V, Qt::CaseSensitivity CS = Qt::CaseInsensitive, size_t N> consteval StaticStringMap<V, N, CS> MakeStaticStringMap(const std::pair<std::string_view, V> (&Entries)[N]) {
+        return StaticStringMap<V, N, CS>(Entries);
+    }
 }
 
 #endif //WRITING_MATERIALS_MANAGER_ALGORITHM_H
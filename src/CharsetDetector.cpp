@@ -0,0 +1,71 @@
+#include "CharsetDetector.h"
+
+#include <algorithm>
+
+#include "UTFConverter.h"
+
+namespace WritingMaterialsManager {
+    QByteArray CharsetDetector::Detect(const QByteArrayView Data) {
+        if (const QByteArray Charset = DetectBOM(Data); Charset.isEmpty() == false) { return Charset; }
+        const QByteArrayView Sample = Data.first(std::min(Data.size(), SampleSize));
+        if (const QByteArray Charset = DetectUTF16(Sample); Charset.isEmpty() == false) { return Charset; }
+        if (UTFConverter::IsValidUTF8(Data)) { return "UTF-8"; } // the whole text is validated, since a GB18030 file may have only a few non-ASCII characters near the end
+        return DetectDoubleByte(Sample);
+    }
+
+    QByteArray CharsetDetector::DetectBOM(const QByteArrayView Data) {
+        if (Data.startsWith("\xEF\xBB\xBF")) { return "UTF-8"; }
+        if (Data.startsWith(QByteArrayView("\xFF\xFE\x00\x00", 4))) { return "UTF-32LE"; } // must be checked before UTF-16LE
+        if (Data.startsWith(QByteArrayView("\x00\x00\xFE\xFF", 4))) { return "UTF-32BE"; }
+        if (Data.startsWith("\xFF\xFE")) { return "UTF-16LE"; }
+        if (Data.startsWith("\xFE\xFF")) { return "UTF-16BE"; }
+        return {};
+    }
+
+    qsizetype CharsetDetector::BOMLength(const QByteArrayView Data) {
+        const QByteArray Charset = DetectBOM(Data);
+        if (Charset.isEmpty()) { return 0; }
+        if (Charset == "UTF-8") { return 3; }
+        return Charset.startsWith("UTF-32") ? 4 : 2;
+    }
+
+    QByteArray CharsetDetector::DetectUTF16(const QByteArrayView Sample) {
+        const qsizetype Pairs = Sample.size() / 2;
+        if (Pairs < 2) { return {}; }
+        qsizetype EvenZeros = 0, OddZeros = 0;
+        for (qsizetype i = 0; i < Pairs * 2; i += 2) {
+            EvenZeros += Sample[i] == '\0';
+            OddZeros += Sample[i + 1] == '\0';
+        }
+        // ASCII in UTF-16 has a zero byte in every code unit, while the other position is almost never zero.
+        if (OddZeros * 10 >= Pairs * 3 && EvenZeros * 20 < Pairs) { return "UTF-16LE"; }
+        if (EvenZeros * 10 >= Pairs * 3 && OddZeros * 20 < Pairs) { return "UTF-16BE"; }
+        return {};
+    }
+
+    QByteArray CharsetDetector::DetectDoubleByte(const QByteArrayView Sample) {
+        // Both charsets use leading bytes 0x81-0xFE. Big5 uses trailing bytes 0x40-0x7E and 0xA1-0xFE, and most of its frequent characters (0xA440-0xC67E) have trailing bytes below 0x7F;
+        // whereas the GB2312 subset of GB18030, which covers nearly all the text in practice, uses 0xA1-0xFE only, and its leading bytes 0xC7-0xF7 are as frequent as the others.
+        const auto* const s = reinterpret_cast<const unsigned char*>(Sample.data());
+        const qsizetype n = Sample.size();
+        qsizetype Big5Evidence = 0, GBEvidence = 0;
+        bool Big5Valid = true;
+        for (qsizetype i = 0; i < n; ++i) { // GB18030 interpretation
+            const unsigned char c = s[i];
+            if (c < 0x80) { continue; }
+            if (i + 1 >= n) { break; } // truncated by the sample
+            const unsigned char t = s[i + 1];
+            if (t >= 0x30 && t <= 0x39) { // 4-byte sequence, which Big5 doesn't have
+                GBEvidence += 4;
+                Big5Valid = false;
+                i += 3;
+                continue;
+            }
+            if (c >= 0xA1 && c <= 0xF9 && t >= 0x40 && t <= 0x7E) { ++Big5Evidence; }
+            else if (c >= 0xC7 && c <= 0xF7 && t >= 0xA1) { ++GBEvidence; }
+            if (c == 0x80 || c == 0xFF || (t >= 0x7F && t <= 0xA0)) { Big5Valid = false; }
+            ++i;
+        }
+        return Big5Valid && Big5Evidence > GBEvidence ? QByteArray("Big5") : QByteArray("GB18030");
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef WRITING_MATERIALS_MANAGER_CHARSETDETECTOR_H
+#define WRITING_MATERIALS_MANAGER_CHARSETDETECTOR_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+
+namespace WritingMaterialsManager {
+    class CharsetDetector { // guess the charset of raw text before decoding it
+    public:
+        static constexpr qsizetype SampleSize = 64 << 10; // bytes inspected by the statistical heuristics
+
+        /**
+         * @param Data the whole raw text, e.g., a mapped file
+         * @return a charset name accepted by QTextCodec::codecForName(). In order: the BOM (if any), UTF-16 without BOM, UTF-8 (including ASCII), Big5 and GB18030 (fallback).
+         */
+        static QByteArray Detect(const QByteArrayView Data);
+        static QByteArray DetectBOM(const QByteArrayView Data); // empty if there's no BOM
+        static qsizetype BOMLength(const QByteArrayView Data);
+    private:
+        static QByteArray DetectUTF16(const QByteArrayView Sample); // by the distribution of zero bytes, since the text is mostly ASCII
+        static QByteArray DetectDoubleByte(const QByteArrayView Sample); // Big5 or GB18030
+    };
+}
+
+#endif //WRITING_MATERIALS_MANAGER_CHARSETDETECTOR_H
@@ -1,17 +1,31 @@
 #include "DataSourceManagerWindow.h"
 
-#include <QFileSystemModel>
+#include <QDebug>
 #include <QGridLayout>
 #include <QPushButton>
 
+#include "FileSystemTreeModel.h"
 #include "QtTreeModel.h"
+#include "StartupProfiler.h"
 
 namespace WritingMaterialsManager {
+    namespace {
+        QModelIndex FindMember(const QModelIndex& Object, const char* const Key) { // the member of a JSON object shown by QtTreeModel
+            const QAbstractItemModel* const Model = Object.model();
+            for (int i = 0; i < Model->rowCount(Object); ++i) {
+                const QModelIndex Member = Model->index(i, 0, Object);
+                if (Member.data().toByteArray() == Key) { return Member; }
+            }
+            return {};
+        }
+    }
+
     DataSourceManagerWindow::DataSourceManagerWindow(QWidget* Parent) : QMainWindow(Parent),
                                                                         CentralWidget(new QWidget(this)),
                                                                         MenuBar(new QMenuBar(this)),
                                                                         StatusBar(new QStatusBar(this)),
-                                                                        DataSourceTab(new QTabWidget(CentralWidget)) {
+                                                                        DataSourceTab(new QTabWidget(CentralWidget)),
+                                                                        InfoLoader(new MongoDBInfoLoader) {
         // preparation
         if (objectName().isEmpty() == true) setObjectName(QString::fromUtf8("WritingMaterialsManager__DataSourceManagerWindow"));
         resize(1280, 720);
@@ -37,30 +51,83 @@ namespace WritingMaterialsManager {
 
         Page* const MongoDBPage = new Page(centralWidget());
         QtTreeModel* MongoDBInfoTree = new QtTreeModel(MongoDBPage);
-        MongoDBInfoTree->FromJSON(MongoDBAccessor.GetDBsAndCollsInfo());
+        MongoDBInfoTree->FromJSON(QStringView(u'"' + tr("正在加载……") + u'"')); // a placeholder row until the databases are listed
         MongoDBPage->TreeView->setModel(MongoDBInfoTree);
-        MongoDBPage->TreeView->expandAll();
-        for (int i = 0; i < 2; ++i) { MongoDBPage->TreeView->resizeColumnToContents(i); }
+        InfoLoader->moveToThread(&MongoDBInfoThread);
+        connect(&MongoDBInfoThread, &QThread::finished, InfoLoader, &QObject::deleteLater);
+        connect(InfoLoader, &MongoDBInfoLoader::DatabasesLoaded, this, [=, this](const MongoDBInfoLoader::SharedTree& Tree) {
+            MongoDBInfoLoaded = true;
+            MongoDBInfoTree->FromTree(Tree.get());
+            MongoDBPage->TreeView->Expand({ .MaxDepth = 1 }); // the collections are listed as each database is expanded
+            MongoDBPage->TreeView->FitColumns();
+        });
+        connect(InfoLoader, &MongoDBInfoLoader::CollectionsLoaded, this, [=](const QByteArray& DatabaseName, const MongoDBInfoLoader::SharedTree& Tree) {
+            const QModelIndex Databases = MongoDBInfoTree->index(0, 0);
+            for (int i = 0; i < MongoDBInfoTree->rowCount(Databases); ++i) {
+                const QModelIndex Database = MongoDBInfoTree->index(i, 0, Databases);
+                if (FindMember(Database, "name").siblingAtColumn(1).data().toByteArray() == DatabaseName) {
+                    MongoDBInfoTree->SetValueFromTree(FindMember(Database, "Collections"), Tree.get());
+                    break;
+                }
+            }
+        });
+        connect(InfoLoader, &MongoDBInfoLoader::Failed, this, [=, this](const QString& Reason) {
+            StatusBar->showMessage(Reason);
+            if (MongoDBInfoLoaded == false) { MongoDBInfoTree->FromJSON(QStringView(u'"' + tr("加载失败") + u'"')); }
+        });
+        connect(MongoDBPage->TreeView, &QTreeView::expanded, this, [=, this](const QModelIndex& Index) { // refresh the collections of a database whenever it's expanded
+            if (MongoDBInfoLoaded == false || Index.parent().isValid() == false || Index.parent().parent().isValid()) { return; } // not a database
+            const QByteArray DatabaseName = FindMember(Index, "name").siblingAtColumn(1).data().toByteArray();
+            QMetaObject::invokeMethod(InfoLoader, [Loader = InfoLoader, DatabaseName]() { Loader->LoadCollections(DatabaseName); }, Qt::QueuedConnection);
+        });
+        MongoDBInfoThread.start();
+        QMetaObject::invokeMethod(InfoLoader, &MongoDBInfoLoader::LoadDatabases, Qt::QueuedConnection);
 
         Page* const FileSystemPage = new Page(centralWidget());
-        QFileSystemModel* FileSystemTree = new QFileSystemModel(FileSystemPage);
-        FileSystemTree->setRootPath(QDir::currentPath());
-        FileSystemTree->setFilter(QDir::AllDirs);
+        FileSystemTreeModel* FileSystemTree = new FileSystemTreeModel(FileSystemPage);
+        FileSystemTree->SetFilter(QDir::AllDirs | QDir::NoDotAndDotDot);
+        FileSystemTree->SetRootPath(QDir::currentPath());
         FileSystemPage->TreeView->setModel(FileSystemTree);
-        FileSystemPage->TreeView->expandAll();
-        for (int i = 0; i < 4; ++i) { FileSystemPage->TreeView->resizeColumnToContents(i); }
+        FileSystemPage->TreeView->expand(FileSystemTree->index(0, 0)); // only the root directory is listed; the others are listed as they're expanded
+        connect(FileSystemTree, &FileSystemTreeModel::DirectoryListed, FileSystemPage->TreeView, [=]() { FileSystemPage->TreeView->FitColumns(); }, Qt::SingleShotConnection); // the columns are widened for the directories expanded later
 
         DataSourceTab->addTab(MongoDBPage, "MongoDB");
         DataSourceTab->addTab(FileSystemPage, "File System");
     }
 
     DataSourceManagerWindow::~DataSourceManagerWindow() {
+        MongoDBInfoThread.quit();
+        MongoDBInfoThread.wait();
         while (DataSourceTab->count()) { delete DataSourceTab->widget(0); }
     }
 
 /// ----------------------------------------------------------------
 
-    DataSourceManagerWindow::Page::Page(QWidget* const Parent) : QWidget(Parent), TreeView(new QTreeView(this)) {
+    MongoDBInfoLoader::MongoDBInfoLoader(const QByteArray& MongoDBURI) : Accessor(MongoDBURI.constData()) {}
+
+    MongoDBInfoLoader::~MongoDBInfoLoader() {}
+
+    void MongoDBInfoLoader::LoadDatabases() {
+        const StartupProfiler::Phase Phase("MongoDB info");
+        try { emit DatabasesLoaded(SharedTree(Accessor.GetDBsAndCollsTree(false))); }
+        catch (const std::exception& e) { // e.g., the server can't be selected in time
+            qDebug() << "Exception at " << __FUNCTION__ << ": Failed to list the databases.";
+            qDebug() << e.what();
+            emit Failed(tr("无法列出数据库：") + QString::fromLocal8Bit(e.what()));
+        }
+    }
+
+    void MongoDBInfoLoader::LoadCollections(const QByteArray& DatabaseName) {
+        try { emit CollectionsLoaded(DatabaseName, SharedTree(Accessor.GetCollectionsTree(DatabaseName))); }
+        catch (const std::exception& e) {
+            qDebug() << "Exception at " << __FUNCTION__ << ": Failed to list the collections.";
+            qDebug() << e.what();
+            emit Failed(tr("无法列出数据库 %1 的集合：").arg(QString::fromUtf8(DatabaseName)) + QString::fromLocal8Bit(e.what()));
+        }
+    }
+/// ----------------------------------------------------------------
+
+    DataSourceManagerWindow::Page::Page(QWidget* const Parent) : QWidget(Parent), TreeView(new class TreeView(this)) {
         setLayout(new QGridLayout);
         layout()->addWidget(TreeView);
         show();
@@ -6,11 +6,31 @@
 #include <QMainWindow>
 #include <QMenuBar>
 #include <QStatusBar>
-#include <QTreeView>
+#include <QThread>
 
 #include "MongoDBAccessor.h"
+#include "QtTreeModel.h"
+#include "TreeView.h"
 
 namespace WritingMaterialsManager {
+    class MongoDBInfoLoader : public QObject { // list the databases & collections in its own thread, so that the UI never waits for the server
+    Q_OBJECT
+    public:
+        using SharedTree = std::shared_ptr<QtTreeModel::Node>; // copyable, to be queued to the UI thread
+
+        explicit MongoDBInfoLoader(const QByteArray& MongoDBURI = MongoDBAccessor::LocalMongoDBURI);
+        ~MongoDBInfoLoader();
+    public slots:
+        void LoadDatabases();
+        void LoadCollections(const QByteArray& DatabaseName);
+    signals:
+        void DatabasesLoaded(const SharedTree& Tree); // the collections of each database are null until they're loaded
+        void CollectionsLoaded(const QByteArray& DatabaseName, const SharedTree& Tree);
+        void Failed(const QString& Reason);
+    private:
+        MongoDBAccessor Accessor; // its connections are shared with the other accessors of the same URI
+    };
+
     class DataSourceManagerWindow : public QMainWindow {
     Q_OBJECT
     public:
@@ -22,7 +42,7 @@ namespace WritingMaterialsManager {
             Page(QWidget* const Parent);
             ~Page();
 
-            QTreeView* TreeView;
+            class TreeView* TreeView;
         };
 
         QWidget* const CentralWidget;
@@ -30,7 +50,9 @@ namespace WritingMaterialsManager {
         QMenuBar* const MenuBar;
         QStatusBar* const StatusBar;
 
-        MongoDBAccessor MongoDBAccessor;
+        MongoDBInfoLoader* const InfoLoader; // deleted when MongoDBInfoThread finishes
+        QThread MongoDBInfoThread;
+        bool MongoDBInfoLoaded = false;
     };
 }
 
@@ -0,0 +1,86 @@
+#include "DocumentCache.h"
+
+#include <cstring>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+
+#include "FileSystemAccessor.h"
+
+namespace WritingMaterialsManager {
+    QString DocumentCache::GetDirectory() { return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/documents"; }
+
+    quint64 DocumentCache::Hash(const QByteArrayView Contents) {
+        // qHashBits() uses AES instructions if available, which is much faster than reading the file. The seeds make it 64-bit even on 32-bit platforms.
+        const quint64 Low = qHashBits(Contents.data(), Contents.size(), 0x5741524D);
+        const quint64 High = sizeof(size_t) >= sizeof(quint64) ? 0 : qHashBits(Contents.data(), Contents.size(), 0x4D4D5754);
+        return High << 32 ^ Low;
+    }
+
+    QString DocumentCache::GetImagePathName(const QString& PathName, const QByteArray& Charset) {
+        QCryptographicHash Key(QCryptographicHash::Sha1);
+        Key.addData(QFileInfo(PathName).absoluteFilePath().toUtf8());
+        Key.addData(QByteArrayView("\0", 1));
+        Key.addData(Charset);
+        return GetDirectory() + '/' + Key.result().toHex() + ".wmmtree";
+    }
+
+    bool DocumentCache::Load(const QString& PathName, const QByteArrayView Contents, const QByteArray& Charset, QtTreeModel& TreeModel) {
+        if (Contents.size() < MinDocumentSize) { return false; }
+        const QString ImagePathName = GetImagePathName(PathName, Charset);
+        if (QFileInfo::exists(ImagePathName) == false) { return false; }
+        try {
+            const std::shared_ptr<QFile> ImageFile = FileSystemAccessor::Open(ImagePathName);
+            const QByteArrayView Image = FileSystemAccessor::Map(ImageFile); // the tree is built from the mapped image directly
+            Header H;
+            if (Image.size() < static_cast<qsizetype>(sizeof(Header))) { return false; }
+            std::memcpy(&H, Image.data(), sizeof(Header));
+            if (std::memcmp(H.Magic, Magic, sizeof(Magic)) != 0 || H.Version != Version || H.ByteOrder != ByteOrder) { return false; }
+            if (H.Size != Contents.size() || H.ModificationTime != QFileInfo(PathName).lastModified().toMSecsSinceEpoch()) { return false; }
+            if (H.ContentHash != Hash(Contents)) { return false; } // e.g., modified within the resolution of the modification time
+            if (TreeModel.FromBinary(Image.sliced(sizeof(Header))) == false) { return false; }
+            ImageFile->setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime); // recently used
+            return true;
+        }
+        catch (const std::runtime_error&) { return false; } // the cache is just an optimization
+    }
+
+    void DocumentCache::Store(const QString& PathName, const QByteArrayView Contents, const QByteArray& Charset, const QtTreeModel& TreeModel) {
+        if (Contents.size() < MinDocumentSize) { return; }
+        Header H{};
+        std::memcpy(H.Magic, Magic, sizeof(Magic));
+        H.Version = Version;
+        H.ByteOrder = ByteOrder;
+        H.Size = Contents.size();
+        H.ModificationTime = QFileInfo(PathName).lastModified().toMSecsSinceEpoch();
+        H.ContentHash = Hash(Contents);
+        QByteArray Image = TreeModel.ToBinary(); // serialized here since the model belongs to this thread
+        if (Image.isEmpty()) { return; }
+        Image.prepend(reinterpret_cast<const char*>(&H), sizeof(Header));
+        QThreadPool::globalInstance()->start([ImagePathName = GetImagePathName(PathName, Charset), Image = std::move(Image)]() {
+            if (QDir().mkpath(GetDirectory()) == false) { return; }
+            QSaveFile ImageFile(ImagePathName); // readers never see a partially written image
+            if (ImageFile.open(QIODevice::WriteOnly) == false) { return; }
+            if (ImageFile.write(Image) != Image.size()) {
+                ImageFile.cancelWriting();
+                return;
+            }
+            if (ImageFile.commit()) { Evict(); }
+        });
+    }
+
+    void DocumentCache::Evict() {
+        const QFileInfoList Images = QDir(GetDirectory()).entryInfoList({ "*.wmmtree" }, QDir::Files, QDir::Time); // the most recently used first
+        qint64 TotalSize = 0;
+        for (const QFileInfo& Image: Images) {
+            TotalSize += Image.size();
+            if (TotalSize > Capacity) { QFile::remove(Image.absoluteFilePath()); }
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef WRITING_MATERIALS_MANAGER_DOCUMENTCACHE_H
+#define WRITING_MATERIALS_MANAGER_DOCUMENTCACHE_H
+
+#include <QByteArray>
+#include <QString>
+
+#include "QtTreeModel.h"
+
+namespace WritingMaterialsManager {
+    /**
+     * Binary images of the trees of large documents in the user cache directory, so that reopening an unchanged file builds its tree without parsing.
+     * An image is keyed by the absolute pathname & the charset, and it's valid only if the size, the modification time and the content hash of the file are all unchanged.
+     */
+    class DocumentCache {
+    public:
+        inline static constexpr qsizetype MinDocumentSize = 1 << 20; // smaller documents are parsed about as fast as their images are loaded
+        inline static constexpr qint64 Capacity = qint64(2) << 30; // the least recently used images are removed when their total size exceeds this
+
+        static QString GetDirectory();
+        static quint64 Hash(const QByteArrayView Contents); // fast, but only stable on the same machine
+
+        /**
+         * Rebuild the tree of a document from its cached image.
+         * @param PathName The pathname of the document.
+         * @param Contents The current raw contents of the document.
+         * @param Charset The charset used for reading the document.
+         * @param TreeModel Reset with the image if it's valid, otherwise unchanged.
+         * @return Whether the image was found and valid.
+         */
+        static bool Load(const QString& PathName, const QByteArrayView Contents, const QByteArray& Charset, QtTreeModel& TreeModel);
+        static void Store(const QString& PathName, const QByteArrayView Contents, const QByteArray& Charset, const QtTreeModel& TreeModel); // the image is written in the background
+    private:
+        struct Header {
+            char Magic[8];
+            quint32 Version;
+            quint32 ByteOrder; // images are only valid on machines with the same byte order
+            qint64 Size;
+            qint64 ModificationTime; // ms since epoch
+            quint64 ContentHash;
+        };
+
+        inline static constexpr char Magic[8] = "WMMTREE";
+        inline static constexpr quint32 Version = 1; // increase this when the image format of QtTreeModel changes
+        inline static constexpr quint32 ByteOrder = 0x01020304;
+
+        static QString GetImagePathName(const QString& PathName, const QByteArray& Charset);
+        static void Evict(); // remove the least recently used images beyond Capacity
+    };
+}
+
+#endif //WRITING_MATERIALS_MANAGER_DOCUMENTCACHE_H
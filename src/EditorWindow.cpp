@@ -5,6 +5,7 @@
 
 #include "MongoDBConsole.h"
 #include "PythonInteractor.h"
+#include "StartupProfiler.h"
 #include "TreeEditor.h"
 
 namespace WritingMaterialsManager {
@@ -28,12 +29,10 @@ namespace WritingMaterialsManager {
         addToolBar(Qt::TopToolBarArea, ToolBar);
 
         QTabWidget* const TabView = new QTabWidget; {
-            auto* const MDBCPage = new MongoConAndEditorPage(this);
-            auto* const EditorPage = new EditorOnlyPage(this);
-            auto* const PyInteractorPage = new PythonInteractorPage(this);
-            TabView->addTab(MDBCPage, "MongoDB Console");
-            TabView->addTab(EditorPage, "Tree Editor Only");
-            TabView->addTab(PyInteractorPage, "Python Interactor");
+            // the pages are created when their tabs are shown, so the startup doesn't wait for the pages never opened
+            TabView->addTab(new LazyPage([this]() { return new MongoConAndEditorPage(this); }), "MongoDB Console");
+            TabView->addTab(new LazyPage([this]() { return new EditorOnlyPage(this); }), "Tree Editor Only");
+            TabView->addTab(new LazyPage([this]() { return new PythonInteractorPage(this); }), "Python Interactor");
         }
         RootView->addWidget(TabView);
 
@@ -66,6 +65,21 @@ namespace WritingMaterialsManager {
     void EditorWindow::UpdateCharsetLabel(const QString& Charset) { CharsetLabel->setText(Charset); }
 /// ----------------------------------------------------------------
 
+    EditorWindow::LazyPage::LazyPage(std::function<QWidget*()> Factory, QWidget* const Parent) : QWidget(Parent), Factory(std::move(Factory)) {
+        setLayout(new QGridLayout);
+        layout()->setContentsMargins(0, 0, 0, 0);
+    }
+
+    void EditorWindow::LazyPage::showEvent(QShowEvent* const Event) {
+        if (Factory != nullptr) {
+            const StartupProfiler::Phase Phase("EditorWindow page");
+            layout()->addWidget(Factory());
+            Factory = nullptr;
+        }
+        QWidget::showEvent(Event);
+    }
+/// ----------------------------------------------------------------
+
     EditorWindow::Page::Page(EditorWindow* const OuterInstance, QWidget* const Parent) : 
         thisAtEditorWindow(OuterInstance), RootView(new QSplitter(this)) {
         RootView->setOrientation(Qt::Vertical);
@@ -84,6 +98,7 @@ namespace WritingMaterialsManager {
             Editor->TabView->setCurrentIndex(1);
         }
         Console->AddAssociatedEditor(Editor);
+        connect(Editor, &TreeEditor::ShouldShowMessage, thisAtEditorWindow, [this](const QString& Message) { thisAtEditorWindow->StatusBar->showMessage(Message); });
 
         auto ShowMongoDBInWndTitle = [=, this]() { this->thisAtEditorWindow->UpdateWindowTitleWithSuffix("MongoDB Console"); };
         connect(Console, &MongoDBConsole::MouseDown, thisAtEditorWindow, ShowMongoDBInWndTitle);
@@ -123,6 +138,7 @@ namespace WritingMaterialsManager {
         AnotherMongoDBConsole* const Console = new AnotherMongoDBConsole;
         TreeEditor* const Editor = new TreeEditor;
         Console->AddAssociatedEditor(Editor);
+        connect(Editor, &TreeEditor::ShouldShowMessage, thisAtEditorWindow, [this](const QString& Message) { thisAtEditorWindow->StatusBar->showMessage(Message); });
 
         RootView->addWidget(Console);
         RootView->addWidget(Editor);
@@ -137,6 +153,7 @@ namespace WritingMaterialsManager {
         connect(Editor, &TreeEditor::ShouldUpdatePathName, thisAtEditorWindow, &EditorWindow::UpdateWindowTitleWithPathName);
         connect(Editor, &TreeEditor::ShouldUpdateFileType, thisAtEditorWindow, qOverload<>(&EditorWindow::UpdateFileTypeLabel));
         connect(Editor, &TreeEditor::ShouldUpdateCharset, thisAtEditorWindow, qOverload<>(&EditorWindow::UpdateCharsetLabel));
+        connect(Editor, &TreeEditor::ShouldShowMessage, thisAtEditorWindow, [this](const QString& Message) { thisAtEditorWindow->StatusBar->showMessage(Message); });
         {
             auto UpdateStatusInfo = [=]() {
                 thisAtEditorWindow->UpdateWindowTitleWithSuffix(Editor->GetPathName());
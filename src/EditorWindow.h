@@ -1,6 +1,8 @@
 #ifndef WRITING_MATERIALS_MANAGER_EDITORWINDOW_H
 #define WRITING_MATERIALS_MANAGER_EDITORWINDOW_H
 
+#include <functional>
+
 #include <QLabel>
 #include <QMainWindow>
 #include <QMenuBar>
@@ -24,6 +26,15 @@ namespace WritingMaterialsManager {
         void UpdateCharsetLabel();
         void UpdateCharsetLabel(const QString& Charset);
     private:
+        class LazyPage : public QWidget { // placeholder of a tab whose content is created the 1st time the tab is shown
+        public:
+            explicit LazyPage(std::function<QWidget*()> Factory, QWidget* const Parent = nullptr);
+        protected:
+            void showEvent(QShowEvent* const Event) override;
+        private:
+            std::function<QWidget*()> Factory; // reset after the content is created
+        };
+
         class Page : public QWidget {
         public:
             QSplitter* RootView;
@@ -1,5 +1,7 @@
 #include "FileSystemAccessor.h"
 
+#include <algorithm>
+
 namespace WritingMaterialsManager {
     std::shared_ptr<QFile> FileSystemAccessor::Open(const QString& PathName, const QIODeviceBase::OpenMode Mode) {
         std::shared_ptr<QFile> File = std::make_shared<QFile>(PathName);
@@ -16,4 +18,84 @@ namespace WritingMaterialsManager {
     QByteArray FileSystemAccessor::GetAllRawContents(const std::shared_ptr<QFile>& File) {
         return File->readAll();
     }
+
+    QByteArrayView FileSystemAccessor::Map(const std::shared_ptr<QFile>& File) {
+        const qint64 Size = File->size();
+        if (Size == 0) { return {}; } // empty files can't be mapped
+        const uchar* const Address = File->map(0, Size);
+        if (Address == nullptr) {
+            throw std::runtime_error(("Map file " + File->fileName() + " failed.").toUtf8().constData());
+        }
+        return QByteArrayView(reinterpret_cast<const char*>(Address), Size);
+    }
+
+    void FileSystemAccessor::Unmap(const std::shared_ptr<QFile>& File, const QByteArrayView View) {
+        if (View.isEmpty() == false) { File->unmap(reinterpret_cast<uchar*>(const_cast<char*>(View.data()))); }
+    }
+
+    QByteArray FileSystemAccessor::GetAllMappedContents(const std::shared_ptr<QFile>& File) {
+        if (File->size() == 0) { return GetAllRawContents(File); } // nothing to map, but a file of size 0 may still have contents to read (e.g., in /proc, or a pipe)
+        try {
+            const QByteArrayView View = Map(File);
+            return QByteArray::fromRawData(View.data(), View.size());
+        }
+        catch (const std::runtime_error&) { // e.g., sequential devices
+            return GetAllRawContents(File);
+        }
+    }
+// ----------------------------------------------------------------
+
+    BufferedFileWriter::BufferedFileWriter(const QString& PathName, const qsizetype BufferSize) :
+        File(PathName), BufferSize(std::max<qsizetype>(BufferSize, 1)), Buffer(new char[this->BufferSize]) {
+        if (File.open(QIODevice::WriteOnly | QIODevice::Unbuffered) == false) { // buffered by this class instead
+            throw std::runtime_error(("Create a temporary file for " + PathName + " failed: " + File.errorString()).toUtf8().constData());
+        }
+    }
+
+    BufferedFileWriter::~BufferedFileWriter() { Cancel(); }
+
+    void BufferedFileWriter::Write(const QByteArrayView Data) {
+        if (Used + Data.size() <= BufferSize) { // the usual case: small pieces
+            std::copy(Data.begin(), Data.end(), Buffer.get() + Used);
+            Used += Data.size();
+            return;
+        }
+        FlushBuffer();
+        if (Data.size() >= BufferSize) { WriteThrough(Data.data(), Data.size()); } // no need to copy into the buffer
+        else {
+            std::copy(Data.begin(), Data.end(), Buffer.get());
+            Used = Data.size();
+        }
+    }
+
+    void BufferedFileWriter::Commit() {
+        FlushBuffer();
+        if (File.commit() == false) { // QSaveFile syncs the temporary file to disk before renaming it
+            throw std::runtime_error(("Save file " + File.fileName() + " failed: " + File.errorString()).toUtf8().constData());
+        }
+    }
+
+    void BufferedFileWriter::Cancel() noexcept {
+        if (File.isOpen()) { // neither committed nor cancelled yet
+            File.cancelWriting();
+            File.commit(); // only closes & removes the temporary file after cancelWriting()
+        }
+    }
+
+    qint64 BufferedFileWriter::GetBytesWritten() const noexcept { return BytesFlushed + Used; }
+
+    void BufferedFileWriter::FlushBuffer() {
+        WriteThrough(Buffer.get(), Used);
+        Used = 0;
+    }
+
+    void BufferedFileWriter::WriteThrough(const char* const Data, const qsizetype Size) {
+        if (Size == 0) { return; }
+        if (File.write(Data, Size) != Size) {
+            const QString Reason = File.errorString();
+            Cancel();
+            throw std::runtime_error(("Write file " + File.fileName() + " failed: " + Reason).toUtf8().constData());
+        }
+        BytesFlushed += Size;
+    }
 }
@@ -3,6 +3,7 @@
 
 #include <QFile>
 #include <QFileInfo>
+#include <QSaveFile>
 
 namespace WritingMaterialsManager {
     class FileSystemAccessor {
@@ -10,6 +11,48 @@ namespace WritingMaterialsManager {
         static std::shared_ptr<QFile> Open(const QString& PathName, const QIODeviceBase::OpenMode Mode = QIODevice::ReadOnly);
         static std::shared_ptr<QFileInfo> GetFileInfo(const std::shared_ptr<QFile>& File);
         static QByteArray GetAllRawContents(const std::shared_ptr<QFile>& File);
+
+        // Zero-copy access. The views are valid until the file is unmapped, closed or destroyed, thus keep the shared_ptr alive while using them.
+
+        static QByteArrayView Map(const std::shared_ptr<QFile>& File); // map the whole file read-only; pages are loaded on demand
+        static void Unmap(const std::shared_ptr<QFile>& File, const QByteArrayView View);
+        static QByteArray GetAllMappedContents(const std::shared_ptr<QFile>& File); // QByteArray::fromRawData() over Map(), NOT null-terminated; falls back to GetAllRawContents() if the file can't be mapped or its size is 0
+    };
+
+    /**
+     * Write a file through a large buffer into a temporary file, which atomically replaces the target after being synced to disk by Commit() (via QSaveFile).
+     * If any write fails, or the writer is destroyed before Commit(), the target is untouched and the temporary file is removed, so there's never a half-written file.
+     * Also a RapidJSON output stream: rapidjson::Writer<BufferedFileWriter> w(Writer);
+     */
+    class BufferedFileWriter {
+    public:
+        using Ch = char;
+
+        static constexpr qsizetype DefaultBufferSize = 8 << 20;
+
+        explicit BufferedFileWriter(const QString& PathName, const qsizetype BufferSize = DefaultBufferSize); // throws std::runtime_error if the temporary file can't be created
+        ~BufferedFileWriter(); // the writing is cancelled if it isn't committed
+
+        void Write(const QByteArrayView Data); // throws std::runtime_error if the buffer can't be written out
+        void Commit(); // flush the buffer, sync & rename; throws std::runtime_error on failure, in which case the target is untouched
+        void Cancel() noexcept;
+        qint64 GetBytesWritten() const noexcept; // including the buffered bytes
+
+        // RapidJSON output stream
+        void Put(const Ch c) {
+            if (Used == BufferSize) { FlushBuffer(); }
+            Buffer[Used++] = c;
+        }
+        void Flush() {} // RapidJSON flushes at the end of each value; the buffer is kept until it's full or committed
+    private:
+        QSaveFile File;
+        const qsizetype BufferSize;
+        const std::unique_ptr<char[]> Buffer;
+        qsizetype Used = 0;
+        qint64 BytesFlushed = 0;
+
+        void FlushBuffer();
+        void WriteThrough(const char* const Data, const qsizetype Size);
     };
 }
 
@@ -0,0 +1,274 @@
+#include "FileSystemTreeModel.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <QDirIterator>
+#include <QFileIconProvider>
+#include <QFileInfo>
+
+namespace WritingMaterialsManager {
+    FileSystemTreeModel::FileSystemTreeModel(QObject* const Parent) : QAbstractItemModel(Parent), Root(std::make_unique<Node>()) {
+        RefreshTimer.setSingleShot(true);
+        RefreshTimer.setInterval(300); // a directory being written is listed again after the changes settle down
+        connect(&Watcher, &QFileSystemWatcher::directoryChanged, this, [this](const QString& Path) {
+            ChangedDirectories.insert(Path);
+            RefreshTimer.start();
+        });
+        connect(&RefreshTimer, &QTimer::timeout, this, &FileSystemTreeModel::Refresh);
+    }
+
+    FileSystemTreeModel::~FileSystemTreeModel() {
+        for (Node* const n: std::as_const(Directories)) {
+            if (n->Cancelled != nullptr) { n->Cancelled->store(true); }
+        }
+        Pool.waitForDone(); // the batches posted to this are discarded with it
+    }
+
+    void FileSystemTreeModel::SetRootPath(const QString& Path) {
+        beginResetModel();
+        if (Root->Children.empty() == false) { Forget(Root->Children.front().get()); }
+        Root->Children.clear();
+        auto RootDirectory = std::make_unique<Node>();
+        RootDirectory->Name = QDir::cleanPath(QFileInfo(Path).absoluteFilePath());
+        RootDirectory->IsDirectory = QFileInfo(Path).isDir();
+        RootDirectory->Parent = Root.get();
+        Root->Children.emplace_back(std::move(RootDirectory));
+        endResetModel();
+    }
+
+    QString FileSystemTreeModel::GetRootPath() const { return Root->Children.empty() ? QString() : Root->Children.front()->Name; }
+
+    void FileSystemTreeModel::SetFilter(const QDir::Filters Filter) { this->Filter = Filter; }
+    QDir::Filters FileSystemTreeModel::GetFilter() const { return Filter; }
+
+    QString FileSystemTreeModel::GetPath(const QModelIndex& Index) const { return Index.isValid() ? PathOf(GetNode(Index)) : QString(); }
+
+    bool FileSystemTreeModel::IsListing(const QModelIndex& Index) const { return Index.isValid() && GetNode(Index)->ListState == Node::State::Listing; }
+
+    QVariant FileSystemTreeModel::headerData(int Section, Qt::Orientation Orientation, int Role) const {
+        if (Orientation != Qt::Horizontal || Role != Qt::DisplayRole) { return {}; }
+        switch (Section) {
+        case NameColumn: return tr("名称");
+        case TypeColumn: return tr("类型");
+        }
+        return {};
+    }
+
+    QModelIndex FileSystemTreeModel::index(int Row, int Column, const QModelIndex& Parent) const {
+        if (hasIndex(Row, Column, Parent) == false) { return {}; }
+        return createIndex(Row, Column, GetNode(Parent)->Children[Row].get());
+    }
+
+    QModelIndex FileSystemTreeModel::parent(const QModelIndex& Index) const {
+        if (Index.isValid() == false) { return {}; }
+        return IndexOf(GetNode(Index)->Parent);
+    }
+
+    int FileSystemTreeModel::rowCount(const QModelIndex& Parent) const {
+        if (Parent.column() > 0) { return 0; }
+        return static_cast<int>(GetNode(Parent)->Children.size());
+    }
+
+    int FileSystemTreeModel::columnCount(const QModelIndex& Parent) const { return ColumnCount; }
+
+    bool FileSystemTreeModel::hasChildren(const QModelIndex& Parent) const {
+        if (Parent.column() > 0) { return false; }
+        const Node* const n = GetNode(Parent);
+        if (n == Root.get()) { return n->Children.empty() == false; }
+        return n->IsDirectory && (n->ListState != Node::State::Listed || n->Children.empty() == false);
+    }
+
+    QVariant FileSystemTreeModel::data(const QModelIndex& Index, int Role) const {
+        if (Index.isValid() == false) { return {}; }
+        const Node* const n = GetNode(Index);
+        switch (Role) {
+        case Qt::DisplayRole:
+            if (Index.column() == NameColumn) { return n->Name; }
+            if (n->ListState == Node::State::Listing) { return tr("目录（正在读取……）"); }
+            return n->IsDirectory ? tr("目录") : tr("文件");
+        case Qt::DecorationRole:
+            if (Index.column() == NameColumn) {
+                static const QFileIconProvider IconProvider; // the generic icons, which needn't read the files
+                return IconProvider.icon(n->IsDirectory ? QAbstractFileIconProvider::Folder : QAbstractFileIconProvider::File);
+            }
+            return {};
+        case Qt::ToolTipRole: return PathOf(n);
+        }
+        return {};
+    }
+
+    bool FileSystemTreeModel::canFetchMore(const QModelIndex& Parent) const {
+        if (Parent.isValid() == false) { return false; }
+        const Node* const n = GetNode(Parent);
+        return n->IsDirectory && n->ListState == Node::State::Unlisted;
+    }
+
+    void FileSystemTreeModel::fetchMore(const QModelIndex& Parent) {
+        if (canFetchMore(Parent)) { List(GetNode(Parent)); }
+    }
+
+    FileSystemTreeModel::Node* FileSystemTreeModel::GetNode(const QModelIndex& Index) const {
+        return Index.isValid() ? static_cast<Node*>(Index.internalPointer()) : Root.get();
+    }
+
+    QModelIndex FileSystemTreeModel::IndexOf(Node* const n) const { return n == Root.get() ? QModelIndex() : createIndex(n->Row, 0, n); }
+
+    QString FileSystemTreeModel::PathOf(const Node* n) const {
+        if (n->Parent == Root.get()) { return n->Name; }
+        QString Path = n->Name;
+        for (n = n->Parent; n->Parent != Root.get(); n = n->Parent) { Path.prepend(n->Name + u'/'); }
+        return n->Name.endsWith(u'/') ? n->Name + Path : n->Name + u'/' + Path; // the root directory may be "/"
+    }
+
+    void FileSystemTreeModel::List(Node* const n) {
+        if (n->Cancelled != nullptr) { n->Cancelled->store(true); } // the previous listing is superseded
+        const auto Cancelled = std::make_shared<std::atomic_bool>(false);
+        n->Cancelled = Cancelled;
+        n->Refreshing = n->ListState == Node::State::Listed;
+        n->Pending.clear();
+        n->ListState = Node::State::Listing;
+        const QString Path = PathOf(n);
+        Directories.insert(Path, n);
+        const QModelIndex Index = IndexOf(n);
+        emit dataChanged(Index.siblingAtColumn(TypeColumn), Index.siblingAtColumn(TypeColumn), { Qt::DisplayRole });
+
+        Pool.start([this, Path, Filter = Filter, Cancelled]() {
+            const auto Post = [&](std::vector<Entry> Entries, const bool Last) {
+                QMetaObject::invokeMethod(this, [this, Path, Cancelled, Entries = std::move(Entries), Last]() mutable {
+                    AppendEntries(Path, Cancelled, std::move(Entries), Last);
+                }, Qt::QueuedConnection);
+            };
+            std::vector<Entry> Batch;
+            Batch.reserve(BatchSize);
+            QDirIterator i(Path, Filter); // readdir(), where the type of each entry is usually known without stat()
+            while (i.hasNext()) {
+                if (Cancelled->load()) { return; }
+                i.next();
+                Batch.push_back({ i.fileName(), i.fileInfo().isDir() });
+                if (static_cast<int>(Batch.size()) == BatchSize) {
+                    Post(std::move(Batch), false);
+                    Batch = {};
+                    Batch.reserve(BatchSize);
+                }
+            }
+            Post(std::move(Batch), true);
+        });
+    }
+
+    void FileSystemTreeModel::AppendEntries(const QString& Path, const std::shared_ptr<std::atomic_bool>& Cancelled, std::vector<Entry> Entries, const bool Last) {
+        const auto i = Directories.constFind(Path);
+        if (i == Directories.cend() || i.value()->Cancelled != Cancelled || Cancelled->load()) { return; } // superseded, or the directory has been removed from the tree
+        Node* const n = i.value();
+        if (n->Refreshing) { n->Pending.insert(n->Pending.end(), std::make_move_iterator(Entries.begin()), std::make_move_iterator(Entries.end())); }
+        else if (Entries.empty() == false) { // shown batch by batch at the 1st listing
+            const int First = static_cast<int>(n->Children.size());
+            beginInsertRows(IndexOf(n), First, First + static_cast<int>(Entries.size()) - 1);
+            for (auto& e: Entries) {
+                auto Child = std::make_unique<Node>();
+                Child->Name = std::move(e.Name);
+                Child->IsDirectory = e.IsDirectory;
+                Child->Parent = n;
+                Child->Row = static_cast<int>(n->Children.size());
+                n->Children.emplace_back(std::move(Child));
+            }
+            endInsertRows();
+        }
+        if (Last == false) { return; }
+
+        const bool WasRefreshing = n->Refreshing;
+        if (WasRefreshing) { Merge(n); }
+        else if (static_cast<qsizetype>(n->Children.size()) <= SortLimit) { Sort(n); }
+        n->ListState = Node::State::Listed;
+        n->Refreshing = false;
+        n->Cancelled = nullptr;
+        if (WasRefreshing == false) { Watcher.addPath(Path); } // cached until it changes
+        const QModelIndex Index = IndexOf(n);
+        emit dataChanged(Index, Index.siblingAtColumn(TypeColumn), { Qt::DisplayRole }); // an empty directory has no children anymore
+        emit DirectoryListed(Path);
+    }
+
+    void FileSystemTreeModel::Merge(Node* const n) {
+        QHash<QString, bool> Fresh; // name -> whether it's a directory
+        Fresh.reserve(n->Pending.size());
+        for (const auto& e: n->Pending) { Fresh.insert(e.Name, e.IsDirectory); }
+        const auto Stale = [&](const int k) {
+            const auto f = Fresh.constFind(n->Children[k]->Name);
+            return f == Fresh.cend() || f.value() != n->Children[k]->IsDirectory;
+        };
+
+        const QModelIndex Parent = IndexOf(n);
+        for (int i = static_cast<int>(n->Children.size()); i > 0;) { // remove the stale entries range by range
+            if (Stale(i - 1) == false) {
+                --i;
+                continue;
+            }
+            int j = i - 1;
+            while (j > 0 && Stale(j - 1)) { --j; }
+            beginRemoveRows(Parent, j, i - 1);
+            for (int k = j; k < i; ++k) { Forget(n->Children[k].get()); }
+            n->Children.erase(n->Children.begin() + j, n->Children.begin() + i);
+            for (int k = j; k < static_cast<int>(n->Children.size()); ++k) { n->Children[k]->Row = k; } // before endRemoveRows(), whose receivers may query the following rows
+            endRemoveRows();
+            i = j;
+        }
+
+        QSet<QString> Existing;
+        Existing.reserve(n->Children.size());
+        for (const auto& Child: n->Children) { Existing.insert(Child->Name); }
+        std::vector<Entry> Added;
+        for (auto& e: n->Pending) {
+            if (Existing.contains(e.Name) == false) { Added.emplace_back(std::move(e)); }
+        }
+        n->Pending = {};
+        if (Added.empty() == false) {
+            const int First = static_cast<int>(n->Children.size());
+            beginInsertRows(Parent, First, First + static_cast<int>(Added.size()) - 1);
+            for (auto& e: Added) {
+                auto Child = std::make_unique<Node>();
+                Child->Name = std::move(e.Name);
+                Child->IsDirectory = e.IsDirectory;
+                Child->Parent = n;
+                Child->Row = static_cast<int>(n->Children.size());
+                n->Children.emplace_back(std::move(Child));
+            }
+            endInsertRows();
+        }
+        if (static_cast<qsizetype>(n->Children.size()) <= SortLimit) { Sort(n); }
+    }
+
+    void FileSystemTreeModel::Sort(Node* const n) {
+        const auto Less = [](const std::unique_ptr<Node>& A, const std::unique_ptr<Node>& B) { // directories first
+            if (A->IsDirectory != B->IsDirectory) { return A->IsDirectory; }
+            return A->Name.compare(B->Name, Qt::CaseInsensitive) < 0;
+        };
+        if (std::is_sorted(n->Children.begin(), n->Children.end(), Less)) { return; }
+        const QModelIndex Parent = IndexOf(n);
+        emit layoutAboutToBeChanged({ QPersistentModelIndex(Parent) }, QAbstractItemModel::VerticalSortHint);
+        std::stable_sort(n->Children.begin(), n->Children.end(), Less);
+        for (int k = 0; k < static_cast<int>(n->Children.size()); ++k) { n->Children[k]->Row = k; }
+        for (const QModelIndex& Index: persistentIndexList()) { // the nodes are unchanged, but their rows are
+            const Node* const Moved = GetNode(Index);
+            if (Moved->Parent == n) { changePersistentIndex(Index, createIndex(Moved->Row, Index.column(), Index.internalPointer())); }
+        }
+        emit layoutChanged({ QPersistentModelIndex(Parent) }, QAbstractItemModel::VerticalSortHint);
+    }
+
+    void FileSystemTreeModel::Forget(Node* const n) {
+        if (n->IsDirectory == false || n->ListState == Node::State::Unlisted) { return; }
+        if (n->Cancelled != nullptr) { n->Cancelled->store(true); }
+        const QString Path = PathOf(n);
+        Directories.remove(Path);
+        ChangedDirectories.remove(Path);
+        if (n->ListState == Node::State::Listed || n->Refreshing) { Watcher.removePath(Path); } // watched since its 1st listing
+        for (const auto& Child: n->Children) { Forget(Child.get()); }
+    }
+
+    void FileSystemTreeModel::Refresh() {
+        const QSet<QString> Changed = std::exchange(ChangedDirectories, {});
+        for (const QString& Path: Changed) {
+            Node* const n = Directories.value(Path);
+            if (n != nullptr && n->ListState == Node::State::Listed) { List(n); } // a directory being listed will be up to date anyway
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef WRITING_MATERIALS_MANAGER_FILESYSTEMTREEMODEL_H
+#define WRITING_MATERIALS_MANAGER_FILESYSTEMTREEMODEL_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <QAbstractItemModel>
+#include <QDir>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QSet>
+#include <QThreadPool>
+#include <QTimer>
+
+namespace WritingMaterialsManager {
+    /**
+     * A file system tree listed lazily: a directory is read (in batches, in the background) only when it's expanded, so that a tree with millions of files opens at once.
+     * Unlike QFileSystemModel, nothing is visited or watched beyond the directories listed. The listings are cached, and a listed directory is watched (by inotify on Linux)
+     * to be listed again when it changes; the existing entries keep their subtrees.
+     */
+    class FileSystemTreeModel : public QAbstractItemModel {
+    Q_OBJECT
+    public:
+        enum Column { NameColumn, TypeColumn, ColumnCount };
+
+        inline static constexpr int BatchSize = 4096; // entries sent to the UI thread at once
+        inline static constexpr int SortLimit = 100000; // larger directories are shown in the order they're read
+
+        explicit FileSystemTreeModel(QObject* const Parent = nullptr);
+        ~FileSystemTreeModel(); // the listings in progress are cancelled & waited for
+
+        void SetRootPath(const QString& Path); // the root directory is the only top-level row
+        QString GetRootPath() const;
+        void SetFilter(const QDir::Filters Filter); // takes effect on the directories listed later
+        QDir::Filters GetFilter() const;
+        QString GetPath(const QModelIndex& Index) const;
+        bool IsListing(const QModelIndex& Index) const; // whether the directory is being read
+
+        QVariant headerData(int Section, Qt::Orientation Orientation, int Role = Qt::DisplayRole) const override;
+        QModelIndex index(int Row, int Column, const QModelIndex& Parent = QModelIndex()) const override;
+        QModelIndex parent(const QModelIndex& Index) const override;
+        int rowCount(const QModelIndex& Parent = QModelIndex()) const override;
+        int columnCount(const QModelIndex& Parent = QModelIndex()) const override;
+        bool hasChildren(const QModelIndex& Parent = QModelIndex()) const override; // a directory is assumed to have children until it's listed
+        QVariant data(const QModelIndex& Index, int Role = Qt::DisplayRole) const override;
+        bool canFetchMore(const QModelIndex& Parent) const override;
+        void fetchMore(const QModelIndex& Parent) override; // start listing the directory
+    signals:
+        void DirectoryListed(const QString& Path);
+    private:
+        struct Entry {
+            QString Name;
+            bool IsDirectory;
+        };
+
+        struct Node {
+            enum class State { Unlisted, Listing, Listed };
+
+            QString Name; // the full path for the root
+            bool IsDirectory = true;
+            Node* Parent = nullptr;
+            std::vector<std::unique_ptr<Node>> Children;
+            State ListState = State::Unlisted;
+            bool Refreshing = false; // listed again; the entries are collected in Pending & merged at the end
+            std::vector<Entry> Pending;
+            std::shared_ptr<std::atomic_bool> Cancelled; // of the listing in progress
+            int Row = 0; // among the children of Parent, kept so that parent() needn't search among (maybe millions of) siblings
+        };
+
+        std::unique_ptr<Node> Root; // the invisible parent of the root directory
+        QDir::Filters Filter = QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden;
+        QHash<QString, Node*> Directories; // the directories listed or being listed, by path
+        QFileSystemWatcher Watcher;
+        QSet<QString> ChangedDirectories; // listed again once the changes settle down
+        QTimer RefreshTimer;
+        QThreadPool Pool; // its own pool, so that it can be waited for on destruction
+
+        Node* GetNode(const QModelIndex& Index) const;
+        QModelIndex IndexOf(Node* const n) const;
+        QString PathOf(const Node* n) const;
+        void List(Node* const n); // read the directory n in the background
+        void AppendEntries(const QString& Path, const std::shared_ptr<std::atomic_bool>& Cancelled, std::vector<Entry> Entries, const bool Last); // a batch from List()
+        void Merge(Node* const n); // replace the entries of n with the pending ones, keeping the subtrees of the remaining entries
+        void Sort(Node* const n);
+        void Forget(Node* const n); // stop the listing & the watching of n and its descendants before they're removed
+        void Refresh(); // list the changed directories again
+    };
+}
+
+#endif // WRITING_MATERIALS_MANAGER_FILESYSTEMTREEMODEL_H
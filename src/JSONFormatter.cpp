@@ -4,6 +4,8 @@
 
 #include <QDebug>
 
+#include "rapidjson/encodedstream.h"
+#include "rapidjson/memorystream.h"
 #include "rapidjson/reader.h"
 #include "rapidjson/prettywriter.h"
 #include "rapidjson/stream.h"
@@ -19,7 +21,7 @@ namespace WritingMaterialsManager {
         using OutputEncoding = UTF16<char16_t>;
 
         GenericReader<InputEncoding, ParsingOutputEncoding> JSONReader;
-        GenericStringStream<InputEncoding> JSONIStream(Text.toStdU16String().c_str());
+        GenericStringStream<InputEncoding> JSONIStream(reinterpret_cast<const char16_t*>(Text.utf16())); // null-terminated, read in place
         GenericStringBuffer<OutputEncoding> JSONOStream;
         PrettyWriter<GenericStringBuffer<OutputEncoding>, ParsingOutputEncoding, OutputEncoding> JSONWriter(JSONOStream);
         try {
@@ -30,6 +32,24 @@ namespace WritingMaterialsManager {
             qDebug() << e.what();
             return;
         }
-        Text = QString::fromStdU16String(JSONOStream.GetString());
+        Text = QString(reinterpret_cast<const QChar*>(JSONOStream.GetString()), JSONOStream.GetSize() / sizeof(OutputEncoding::Ch));
+    }
+
+    // The source needn't be null-terminated. Throws std::runtime_error on parsing errors.
+    QString JSONFormatter::Format(const QByteArrayView UTF8Text) {
+        using namespace std;
+        using namespace rapidjson;
+
+        using InputEncoding = UTF8<>;
+        using OutputEncoding = UTF16<char16_t>;
+
+        GenericReader<InputEncoding, InputEncoding> JSONReader;
+        MemoryStream JSONMemoryStream(UTF8Text.data(), UTF8Text.size());
+        EncodedInputStream<InputEncoding, MemoryStream> JSONIStream(JSONMemoryStream); // skips the BOM if any
+        GenericStringBuffer<OutputEncoding> JSONOStream;
+        PrettyWriter<GenericStringBuffer<OutputEncoding>, InputEncoding, OutputEncoding> JSONWriter(JSONOStream);
+        ParseResult ParseResult = JSONReader.Parse<ParseFlag::kParseFullPrecisionFlag>(JSONIStream, JSONWriter);
+        if (ParseResult.IsError()) throw runtime_error(string("Exception at ") + __FUNCTION__ + ": Parsing ERROR.");
+        return QString(reinterpret_cast<const QChar*>(JSONOStream.GetString()), JSONOStream.GetSize() / sizeof(OutputEncoding::Ch));
     }
 }
@@ -7,6 +7,7 @@ namespace WritingMaterialsManager {
     class JSONFormatter : public TextFormatter {
     public:
         void Format(QString& Text) override;
+        QString Format(const QByteArrayView UTF8Text) override;
     };
 }
 
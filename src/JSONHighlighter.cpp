@@ -6,9 +6,7 @@ namespace WritingMaterialsManager {
     void JSONHighlighter::OneOffInit() {
         // set color of keywords
         KeywordFormat.setForeground(VisualStudioColorTheme.Keyword);
-        for (const QString& KeywordPattern: KeywordPatterns) {
-            HighlightRules.emplace_back(HighlightRule{ QRegularExpression(KeywordPattern), KeywordFormat });
-        }
+        HighlightRules.emplace_back(HighlightRule{ QRegularExpression(KeywordCandidatePattern), KeywordFormat, [](QStringView Matched) { return Keywords.Contains(Matched); } });
 
         // set color of numbers
         NumberFormat.setForeground(VisualStudioColorTheme.Number);
@@ -158,39 +156,25 @@ namespace WritingMaterialsManager {
         }
 
         // match and highlight keywords and numbers in non-string parts
+        auto ApplyRule = [this](const HighlightRule& Rule, const QStringView Segment, const qsizetype Offset) {
+            QRegularExpressionMatchIterator MatchIterator = Rule.Pattern.globalMatch(Segment);
+            while (MatchIterator.hasNext()) {
+                const QRegularExpressionMatch Match = MatchIterator.next();
+                if (Rule.Accept != nullptr && Rule.Accept(Match.capturedView()) == false) { continue; }
+                setFormat(Offset + Match.capturedStart(), Match.capturedLength(), Rule.Format);
+            }
+        };
         QStringView TextRef(Text);
         if (StrBeginPos.empty()) {
-            for (const auto& HighlightRule: HighlightRules) {
-                QRegularExpressionMatchIterator MatchIterator = HighlightRule.Pattern.globalMatch(Text);
-                while (MatchIterator.hasNext()) {
-                    QRegularExpressionMatch Match = MatchIterator.next();
-                    setFormat(Match.capturedStart(), Match.capturedLength(), HighlightRule.Format);
-                }
-            }
+            for (const auto& HighlightRule: HighlightRules) { ApplyRule(HighlightRule, TextRef, 0); }
         }
         else {
             for (const auto& HighlightRule: HighlightRules) {
-                {
-                    QRegularExpressionMatchIterator MatchIterator = HighlightRule.Pattern.globalMatch(TextRef.sliced(0, StrBeginPos[0]));
-                    while (MatchIterator.hasNext()) {
-                        QRegularExpressionMatch Match = MatchIterator.next();
-                        setFormat(Match.capturedStart(), Match.capturedLength(), HighlightRule.Format);
-                    }
-                }
+                ApplyRule(HighlightRule, TextRef.sliced(0, StrBeginPos[0]), 0);
                 for (size_t i = 0; i < StrEndPos.size() - 1; ++i) {
-                    QRegularExpressionMatchIterator MatchIterator = HighlightRule.Pattern.globalMatch(TextRef.sliced(StrEndPos[i], StrBeginPos[i + 1] - StrEndPos[i]));
-                    while (MatchIterator.hasNext()) {
-                        QRegularExpressionMatch Match = MatchIterator.next();
-                        setFormat(StrEndPos[i] + Match.capturedStart(), Match.capturedLength(), HighlightRule.Format);
-                    }
-                }
-                {
-                    QRegularExpressionMatchIterator MatchIterator = HighlightRule.Pattern.globalMatch(TextRef.sliced(StrEndPos[StrEndPos.size() - 1]));
-                    while (MatchIterator.hasNext()) {
-                        QRegularExpressionMatch Match = MatchIterator.next();
-                        setFormat(StrEndPos[StrEndPos.size() - 1] + Match.capturedStart(), Match.capturedLength(), HighlightRule.Format);
-                    }
+                    ApplyRule(HighlightRule, TextRef.sliced(StrEndPos[i], StrBeginPos[i + 1] - StrEndPos[i]), StrEndPos[i]);
                 }
+                ApplyRule(HighlightRule, TextRef.sliced(StrEndPos[StrEndPos.size() - 1]), StrEndPos[StrEndPos.size() - 1]);
             }
         }
     }
@@ -5,6 +5,7 @@
 
 #include <QRegularExpression>
 
+#include "Algorithm.h"
 #include "TextHighlighter.h"
 
 namespace WritingMaterialsManager {
@@ -40,9 +41,16 @@ namespace WritingMaterialsManager {
         struct HighlightRule {
             QRegularExpression Pattern;
             QTextCharFormat Format;
+            bool (*Accept)(QStringView Matched) = nullptr; // optional filter of the matched text; nullptr accepts everything
         };
 
-        inline static const QString KeywordPatterns[] = { R"(\btrue\b)", R"(\bfalse\b)", R"(\bnull\b)" };
+        enum class Keyword : size_t { True, False, Null, };
+        inline static constexpr auto Keywords = MakeStaticStringMap<Keyword, Qt::CaseSensitive>({
+            { "true",  Keyword::True },
+            { "false", Keyword::False },
+            { "null",  Keyword::Null },
+        });
+        inline static const QString KeywordCandidatePattern{ R"(\b[a-z]+\b)" }; // a single regex pass finds all the candidates, which are then looked up in Keywords
 /*
  * general integers: 123456, 0123, +5, -2, ++++987, ----456, +-+-+--12
  * general floats: 0.123, .1234, 000.2345, 98765.4321, +1.23, -2.56, ++3.1, ---6.0, +-7.7
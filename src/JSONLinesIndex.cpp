@@ -0,0 +1,76 @@
+#include "JSONLinesIndex.h"
+
+#include <bit>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WMM_SSE2 // SSE2 is a part of x86-64, so no runtime detection is needed
+#include <emmintrin.h>
+#endif
+
+namespace WritingMaterialsManager {
+    namespace {
+        inline bool IsBlank(const char c) noexcept { return c == ' ' || c == '\t' || c == '\r'; }
+
+        template<class F> void ForEachNewline(const char* const s, const qsizetype n, const F& Function) { // Function(Offset) for each '\n' in ascending order
+            qsizetype i = 0;
+#ifdef WMM_SSE2
+            const __m128i Newline = _mm_set1_epi8('\n');
+            for (; i + 16 <= n; i += 16) {
+                for (uint32_t Mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)), Newline)); Mask != 0; Mask &= Mask - 1) {
+                    Function(i + std::countr_zero(Mask));
+                }
+            }
+#else
+            constexpr uint64_t Ones = 0x0101010101010101, HighBits = 0x8080808080808080;
+            for (uint64_t w; i + 8 <= n; i += 8) {
+                std::memcpy(&w, s + i, 8);
+                w ^= Ones * '\n'; // the bytes of newlines become 0
+                if (((w - Ones) & ~w & HighBits) == 0) { continue; } // no zero byte
+                for (int k = 0; k < 8; ++k) { if (s[i + k] == '\n') { Function(i + k); } }
+            }
+#endif
+            for (; i < n; ++i) { if (s[i] == '\n') { Function(i); } }
+        }
+    }
+
+    JSONLinesIndex::JSONLinesIndex(const QByteArrayView Text, std::shared_ptr<const void> Owner) : Owner(std::move(Owner)), Text(Text) {
+        const char* const s = Text.data();
+        Begin.reserve(Text.size() / 128); // a rough guess to avoid most of the reallocations
+        qsizetype LineBegin = 0;
+        const auto AddLine = [this, s, &LineBegin](const qsizetype LineEnd) {
+            for (qsizetype i = LineBegin; i < LineEnd; ++i) {
+                if (IsBlank(s[i]) == false) { // blank lines aren't records
+                    Begin.emplace_back(LineBegin);
+                    break;
+                }
+            }
+            LineBegin = LineEnd + 1;
+        };
+        ForEachNewline(s, Text.size(), AddLine);
+        AddLine(Text.size()); // the last line may have no newline
+        Begin.shrink_to_fit();
+    }
+
+    qsizetype JSONLinesIndex::Count() const noexcept { return static_cast<qsizetype>(Begin.size()); }
+
+    qsizetype JSONLinesIndex::Offset(const qsizetype N) const noexcept { return N >= 0 && N < Count() ? Begin[N] : Text.size(); }
+
+    QByteArrayView JSONLinesIndex::Record(const qsizetype N) const noexcept {
+        if (N < 0 || N >= Count()) { return {}; } // OOB
+        const qsizetype First = Begin[N];
+        const void* const Newline = std::memchr(Text.data() + First, '\n', Text.size() - First);
+        const qsizetype End = Newline != nullptr ? static_cast<const char*>(Newline) - Text.data() : Text.size();
+        return Text.sliced(First, End - First).trimmed();
+    }
+
+    QByteArrayView JSONLinesIndex::GetText() const noexcept { return Text; }
+
+    std::shared_ptr<const JSONLinesIndex> JSONLinesIndex::Detached() const {
+        const auto Copy = std::make_shared<const QByteArray>(Text.toByteArray());
+        const auto Result = std::make_shared<JSONLinesIndex>(*this); // the offsets aren't found again
+        Result->Text = *Copy;
+        Result->Owner = Copy;
+        return Result;
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef WRITING_MATERIALS_MANAGER_JSONLINESINDEX_H
+#define WRITING_MATERIALS_MANAGER_JSONLINESINDEX_H
+
+#include <memory>
+#include <vector>
+
+#include <QByteArray>
+
+namespace WritingMaterialsManager {
+    /**
+     * Offsets of the records (non-blank lines) of UTF-8 JSON Lines (NDJSON), so that any record can be accessed in O(1) without parsing the others.
+     * The newlines are found 16 bytes at a time with SSE2 (or 8 bytes at a time on other CPUs). The text isn't copied, e.g., it can be a mapped file.
+     */
+    class JSONLinesIndex {
+    public:
+        /**
+         * @param Text The JSON Lines to be indexed. It must be valid during the lifetime of this index.
+         * @param Owner Anything that keeps Text valid (e.g., the mapped file), released with this index.
+         */
+        explicit JSONLinesIndex(const QByteArrayView Text, std::shared_ptr<const void> Owner = {});
+
+        qsizetype Count() const noexcept; // number of records
+        qsizetype Offset(const qsizetype N) const noexcept; // the offset of the Nth record in the text
+        QByteArrayView Record(const qsizetype N) const noexcept; // the Nth record without the leading/trailing whitespaces; empty if N is out of bound
+        QByteArrayView GetText() const noexcept;
+        std::shared_ptr<const JSONLinesIndex> Detached() const; // the same index of a copy of the text in memory, e.g., to release the mapped file
+    private:
+        std::shared_ptr<const void> Owner;
+        QByteArrayView Text;
+        std::vector<qsizetype> Begin; // the offset of each record
+    };
+}
+
+#endif //WRITING_MATERIALS_MANAGER_JSONLINESINDEX_H
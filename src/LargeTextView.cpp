@@ -0,0 +1,282 @@
+#include "LargeTextView.h"
+
+#include <algorithm>
+#include <climits>
+
+#include <QKeyEvent>
+#include <QPainter>
+#include <QScrollBar>
+
+#include "global.h"
+
+namespace WritingMaterialsManager {
+    namespace {
+        QString ExpandTabs(const QStringView Text, const int TabSize) { // QPainter::drawText() doesn't align tabs
+            QString Result;
+            Result.reserve(Text.size());
+            for (const QChar c: Text) {
+                if (c == u'\t') { Result.append(QString(TabSize - Result.size() % TabSize, u' ')); }
+                else { Result.append(c); }
+            }
+            return Result;
+        }
+
+        bool IsContinuation(const char c) { return (static_cast<quint8>(c) & 0xC0) == 0x80; }
+        qsizetype SequenceLength(const char Lead) { // an invalid byte is a sequence by itself
+            const quint8 c = static_cast<quint8>(Lead);
+            return c < 0xC0 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+        }
+    }
+
+    LargeTextView::LargeTextView(QWidget* const Parent) : QAbstractScrollArea(Parent) {
+        setFont(DefaultCodeFont);
+        setFocusPolicy(Qt::StrongFocus);
+        viewport()->setCursor(Qt::IBeamCursor);
+    }
+
+    void LargeTextView::SetText(const QByteArrayView UTF8, std::shared_ptr<const void> Owner) {
+        Table = PieceTable(UTF8, std::move(Owner));
+        CursorLine = CursorColumn = 0;
+        MaxLineLength = 0;
+        Modified = false;
+        verticalScrollBar()->setValue(0);
+        horizontalScrollBar()->setValue(0);
+        UpdateScrollBars();
+        viewport()->update();
+    }
+
+    void LargeTextView::ResetText(const QByteArrayView UTF8, std::shared_ptr<const void> Owner) {
+        Q_ASSERT(UTF8.size() == Table.Size());
+        Table = PieceTable(UTF8, std::move(Owner));
+        Modified = false;
+        viewport()->update();
+    }
+
+    void LargeTextView::DetachText() { Table.DetachOriginal(); }
+
+    void LargeTextView::AppendText(const QByteArrayView UTF8) {
+        Table.Insert(Table.Size(), UTF8);
+        UpdateScrollBars();
+        viewport()->update();
+    }
+
+    const PieceTable& LargeTextView::GetTable() const { return Table; }
+
+    bool LargeTextView::IsModified() const { return Modified; }
+    void LargeTextView::SetModified(const bool Modified) { this->Modified = Modified; }
+    void LargeTextView::SetReadOnly(const bool ReadOnly) { this->ReadOnly = ReadOnly; }
+
+    qsizetype LargeTextView::GetCursorLine() const { return CursorLine; }
+
+    qsizetype LargeTextView::GetCursorOffset() const { return Table.LineStart(CursorLine) + CursorColumn; }
+
+    void LargeTextView::SetCursor(const qsizetype Line, const qsizetype Column) {
+        CursorLine = std::clamp<qsizetype>(Line, 0, Table.LineCount() - 1);
+        CursorColumn = SequenceStart(CursorLine, Column); // not inside a UTF-8 sequence
+        if (CursorLine < FirstVisibleLine()) { verticalScrollBar()->setValue(static_cast<int>(CursorLine)); }
+        else if (CursorLine >= FirstVisibleLine() + VisibleLineCount()) { verticalScrollBar()->setValue(static_cast<int>(CursorLine - VisibleLineCount() + 1)); }
+        const auto ScrollTo = [this](const qsizetype Column) {
+            const int Value = static_cast<int>(std::min<qsizetype>(Column, INT_MAX));
+            if (Value > horizontalScrollBar()->maximum()) { horizontalScrollBar()->setMaximum(Value); }
+            horizontalScrollBar()->setValue(Value);
+        };
+        const int Width = viewport()->width() - 2 * Margin;
+        const qsizetype First = FirstVisibleColumn(CursorLine);
+        if (CursorColumn < First) { ScrollTo(CursorColumn); }
+        else if (CursorColumn - First > WindowLength() || TextWidth(Window(CursorLine, First, CursorColumn - First)) > Width) { // right of the viewport: show it at the right edge
+            const qsizetype From = SequenceStart(CursorLine, CursorColumn - WindowLength());
+            const QString Before = Window(CursorLine, From, CursorColumn - From);
+            qsizetype Shown = Before.size(); // the code units before the 1st one shown
+            for (int X = 0; Shown > 0;) {
+                const qsizetype n = Shown > 1 && Before[Shown - 1].isLowSurrogate() ? 2 : 1;
+                X += TextWidth(QStringView(Before).sliced(Shown - n, n));
+                if (X > Width) { break; }
+                Shown -= n;
+            }
+            ScrollTo(From + QStringView(Before).first(Shown).toUtf8().size());
+        }
+        viewport()->update();
+    }
+
+    void LargeTextView::GoToOffset(const qsizetype Offset) {
+        const qsizetype Line = Table.LineOf(Offset);
+        SetCursor(Line, Offset - Table.LineStart(Line));
+    }
+
+    void LargeTextView::paintEvent(QPaintEvent* const E) {
+        QPainter Painter(viewport());
+        Painter.fillRect(E->rect(), palette().base());
+        Painter.setPen(palette().text().color());
+        const int LineHeight = fontMetrics().height();
+        bool Longer = false;
+        qsizetype Line = FirstVisibleLine();
+        for (int Y = 0; Line < Table.LineCount() && Y < viewport()->height(); ++Line, Y += LineHeight) { // only the visible part of the visible lines is decoded
+            if (const qsizetype Length = LineLength(Line); Length > MaxLineLength) {
+                MaxLineLength = Length;
+                Longer = true;
+            }
+            const qsizetype Start = FirstVisibleColumn(Line);
+            qsizetype End;
+            Painter.drawText(Margin, Y + fontMetrics().ascent(), ExpandTabs(Window(Line, Start, WindowLength(), &End), TabSize));
+            if (Line == CursorLine && hasFocus() && CursorColumn >= Start && CursorColumn <= End) {
+                Painter.fillRect(Margin + TextWidth(Window(Line, Start, CursorColumn - Start)), Y, 1, LineHeight, palette().text());
+            }
+        }
+        if (Longer) { QMetaObject::invokeMethod(this, &LargeTextView::UpdateScrollBars, Qt::QueuedConnection); } // not while painting
+    }
+
+    void LargeTextView::resizeEvent(QResizeEvent* const E) {
+        QAbstractScrollArea::resizeEvent(E);
+        UpdateScrollBars();
+    }
+
+    void LargeTextView::keyPressEvent(QKeyEvent* const E) {
+        const qsizetype Page = std::max(VisibleLineCount() - 1, 1);
+        switch (E->key()) {
+        case Qt::Key_Up: SetCursor(CursorLine - 1, CursorColumn); break;
+        case Qt::Key_Down: SetCursor(CursorLine + 1, CursorColumn); break;
+        case Qt::Key_PageUp: SetCursor(CursorLine - Page, CursorColumn); break;
+        case Qt::Key_PageDown: SetCursor(CursorLine + Page, CursorColumn); break;
+        case Qt::Key_Left:
+            if (CursorColumn > 0) { SetCursor(CursorLine, CursorColumn - 1); } // to the beginning of the previous code point
+            else if (CursorLine > 0) { SetCursor(CursorLine - 1, LineLength(CursorLine - 1)); }
+            break;
+        case Qt::Key_Right:
+            if (CursorColumn < LineLength(CursorLine)) { SetCursor(CursorLine, NextColumn(CursorLine, CursorColumn)); }
+            else if (CursorLine + 1 < Table.LineCount()) { SetCursor(CursorLine + 1, 0); }
+            break;
+        case Qt::Key_Home: E->modifiers() & Qt::ControlModifier ? SetCursor(0, 0) : SetCursor(CursorLine, 0); break;
+        case Qt::Key_End: E->modifiers() & Qt::ControlModifier ? SetCursor(Table.LineCount() - 1, LineLength(Table.LineCount() - 1)) : SetCursor(CursorLine, LineLength(CursorLine)); break;
+        case Qt::Key_Backspace: RemoveBackward(); break;
+        case Qt::Key_Delete: RemoveForward(); break;
+        case Qt::Key_Return: case Qt::Key_Enter: Insert(QStringLiteral("\n")); break;
+        default:
+            if (const QString Text = E->text(); Text.isEmpty() == false && (Text[0].isPrint() || Text[0] == u'\t')) { Insert(Text); }
+            else {
+                QAbstractScrollArea::keyPressEvent(E);
+                return;
+            }
+        }
+        E->accept();
+    }
+
+    void LargeTextView::mousePressEvent(QMouseEvent* const E) {
+        const qsizetype Line = std::min(FirstVisibleLine() + E->position().toPoint().y() / fontMetrics().height(), Table.LineCount() - 1);
+        const qsizetype Start = FirstVisibleColumn(Line);
+        const QString Text = Window(Line, Start, WindowLength());
+        const int X = E->position().toPoint().x() - Margin;
+        qsizetype Low = 0, High = Text.size(); // binary search for the most code units whose width is no more than X, as the width grows with the prefix
+        while (Low < High) {
+            const qsizetype Middle = (Low + High + 1) / 2;
+            if (TextWidth(QStringView(Text).first(Middle)) <= X) { Low = Middle; }
+            else { High = Middle - 1; }
+        }
+        if (Low < Text.size()) { // the nearer boundary of the code point under X
+            const qsizetype n = Text[Low].isHighSurrogate() && Low + 1 < Text.size() ? 2 : 1;
+            if (X - TextWidth(QStringView(Text).first(Low)) > TextWidth(QStringView(Text).first(Low + n)) - X) { Low += n; }
+        }
+        if (Low > 0 && Low < Text.size() && Text[Low].isLowSurrogate()) { --Low; }
+        SetCursor(Line, Start + QStringView(Text).first(Low).toUtf8().size());
+        emit MouseDown();
+    }
+
+    void LargeTextView::scrollContentsBy(int, int) { viewport()->update(); }
+
+    qsizetype LargeTextView::LineLength(const qsizetype Line) const {
+        const qsizetype Start = Table.LineStart(Line);
+        qsizetype End = Line + 1 < Table.LineCount() ? Table.LineStart(Line + 1) - 1 : Table.Size();
+        if (End > Start && Table.Text(End - 1, 1) == "\r") { --End; } // CRLF
+        return End - Start;
+    }
+
+    qsizetype LargeTextView::SequenceStart(const qsizetype Line, qsizetype Column) const {
+        Column = std::clamp<qsizetype>(Column, 0, LineLength(Line));
+        const qsizetype Before = std::min<qsizetype>(Column, 3); // a sequence has 3 continuation bytes at most, which also bounds the back-off in invalid UTF-8
+        const QByteArray Bytes = Table.Text(Table.LineStart(Line) + Column - Before, Before + 1);
+        qsizetype i = Before;
+        while (i > 0 && i < Bytes.size() && IsContinuation(Bytes[i])) { --i; }
+        return Column - (Before - i);
+    }
+
+    qsizetype LargeTextView::NextColumn(const qsizetype Line, const qsizetype Column) const {
+        const qsizetype Length = LineLength(Line);
+        if (Column >= Length) { return Length; }
+        const QByteArray Bytes = Table.Text(Table.LineStart(Line) + Column, 4);
+        qsizetype n = 1;
+        while (n < SequenceLength(Bytes[0]) && n < Bytes.size() && IsContinuation(Bytes[n])) { ++n; }
+        return std::min(Column + n, Length);
+    }
+
+    QString LargeTextView::Window(const qsizetype Line, qsizetype Start, const qsizetype Length, qsizetype* const End) const {
+        const qsizetype LineEnd = LineLength(Line);
+        Start = std::clamp<qsizetype>(Start, 0, LineEnd);
+        qsizetype n = std::clamp<qsizetype>(Length, 0, LineEnd - Start);
+        QByteArray Bytes = Table.Text(Table.LineStart(Line) + Start, std::min<qsizetype>(n + 3, LineEnd - Start)); // with the rest of the last sequence
+        while (n < Bytes.size() && IsContinuation(Bytes[n])) { ++n; }
+        Bytes.truncate(n);
+        if (End != nullptr) { *End = Start + n; }
+        return QString::fromUtf8(Bytes);
+    }
+
+    qsizetype LargeTextView::WindowLength() const { return 4 * (viewport()->width() / std::max(fontMetrics().horizontalAdvance(u' '), 1) + 1); } // 4 bytes per column at most
+
+    qsizetype LargeTextView::FirstVisibleLine() const { return verticalScrollBar()->value(); }
+
+    qsizetype LargeTextView::FirstVisibleColumn(const qsizetype Line) const { return SequenceStart(Line, horizontalScrollBar()->value()); }
+
+    int LargeTextView::VisibleLineCount() const { return std::max(viewport()->height() / fontMetrics().height(), 1); }
+
+    int LargeTextView::TextWidth(const QStringView Text) const { return fontMetrics().horizontalAdvance(ExpandTabs(Text, TabSize)); }
+
+    void LargeTextView::UpdateScrollBars() {
+        const qsizetype Lines = Table.LineCount();
+        verticalScrollBar()->setRange(0, static_cast<int>(std::clamp<qsizetype>(Lines - VisibleLineCount(), 0, INT_MAX))); // 1 step per line
+        verticalScrollBar()->setPageStep(VisibleLineCount());
+        const qsizetype Columns = std::max(viewport()->width() - 2 * Margin, 0) / std::max(fontMetrics().horizontalAdvance(u' '), 1);
+        horizontalScrollBar()->setRange(0, static_cast<int>(std::clamp<qsizetype>(MaxLineLength - Columns, 0, INT_MAX))); // 1 step per byte
+        horizontalScrollBar()->setPageStep(static_cast<int>(std::max<qsizetype>(Columns, 1)));
+    }
+
+    void LargeTextView::Insert(const QString& Text) {
+        if (ReadOnly) { return; }
+        const QByteArray UTF8 = Text.toUtf8();
+        Table.Insert(GetCursorOffset(), UTF8);
+        const qsizetype Break = UTF8.lastIndexOf('\n');
+        if (Break < 0) { SetCursor(CursorLine, CursorColumn + UTF8.size()); }
+        else { SetCursor(CursorLine + UTF8.count('\n'), UTF8.size() - Break - 1); }
+        Modified = true;
+        UpdateScrollBars();
+        emit TextChanged();
+    }
+
+    void LargeTextView::RemoveBackward() {
+        if (ReadOnly || (CursorLine == 0 && CursorColumn == 0)) { return; }
+        const qsizetype End = GetCursorOffset();
+        if (CursorColumn == 0) { // join with the previous line
+            const qsizetype PreviousLength = LineLength(CursorLine - 1);
+            const qsizetype Start = Table.LineStart(CursorLine - 1) + PreviousLength; // the CR of CRLF is removed as well
+            Table.Remove(Start, End - Start);
+            SetCursor(CursorLine - 1, PreviousLength);
+        }
+        else {
+            const qsizetype Column = SequenceStart(CursorLine, CursorColumn - 1);
+            Table.Remove(End - (CursorColumn - Column), CursorColumn - Column);
+            SetCursor(CursorLine, Column);
+        }
+        Modified = true;
+        UpdateScrollBars();
+        emit TextChanged();
+    }
+
+    void LargeTextView::RemoveForward() {
+        if (ReadOnly) { return; }
+        const qsizetype Start = GetCursorOffset();
+        if (CursorColumn < LineLength(CursorLine)) { Table.Remove(Start, NextColumn(CursorLine, CursorColumn) - CursorColumn); }
+        else if (CursorLine + 1 < Table.LineCount()) { Table.Remove(Start, Table.LineStart(CursorLine + 1) - Start); } // join with the next line
+        else { return; }
+        Modified = true;
+        UpdateScrollBars();
+        viewport()->update();
+        emit TextChanged();
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef WRITING_MATERIALS_MANAGER_LARGETEXTVIEW_H
+#define WRITING_MATERIALS_MANAGER_LARGETEXTVIEW_H
+
+#include <QAbstractScrollArea>
+
+#include "PieceTable.h"
+
+namespace WritingMaterialsManager {
+    /**
+     * Plain text view & editor for huge UTF-8 text (e.g., a mapped file of hundreds of MB), which QPlainTextEdit doesn't scale to.
+     * The text is kept in a PieceTable, and only the lines in the viewport are decoded and drawn; no layout of the whole text is ever made.
+     * Even a single line of hundreds of MB (e.g., minified JSON) is decoded in a bounded window around the viewport, so the horizontal positions are byte offsets in the line rather than pixels.
+     */
+    class LargeTextView : public QAbstractScrollArea {
+    Q_OBJECT
+    public:
+        explicit LargeTextView(QWidget* const Parent = nullptr);
+
+        void SetText(const QByteArrayView UTF8, std::shared_ptr<const void> Owner = {}); // not copied; Owner keeps UTF8 valid (see PieceTable)
+        void ResetText(const QByteArrayView UTF8, std::shared_ptr<const void> Owner = {}); // SetText() with the same text (e.g., of the file it's just saved to), which keeps the cursor & the view
+        void DetachText(); // copy the part of the text still in the Owner of SetText() into memory (see PieceTable::DetachOriginal())
+        void AppendText(const QByteArrayView UTF8);
+        const PieceTable& GetTable() const;
+        bool IsModified() const;
+        void SetModified(const bool Modified);
+        void SetReadOnly(const bool ReadOnly);
+
+        qsizetype GetCursorLine() const;
+        qsizetype GetCursorOffset() const; // the byte offset of the cursor in the text
+        void SetCursor(const qsizetype Line, const qsizetype Column); // Column is the byte offset in the line; the cursor is shown in the viewport
+        void GoToOffset(const qsizetype Offset); // move the cursor to the byte offset in O(log n) time
+    signals:
+        void MouseDown();
+        void TextChanged(); // edited by the user
+    protected:
+        void paintEvent(QPaintEvent* const E) override;
+        void resizeEvent(QResizeEvent* const E) override;
+        void keyPressEvent(QKeyEvent* const E) override;
+        void mousePressEvent(QMouseEvent* const E) override;
+        void scrollContentsBy(int DX, int DY) override;
+    private:
+        inline static constexpr int Margin = 4;
+        inline static constexpr int TabSize = 4;
+
+        PieceTable Table;
+        qsizetype CursorLine = 0;
+        qsizetype CursorColumn = 0; // in bytes, at the beginning of a UTF-8 sequence
+        bool Modified = false;
+        bool ReadOnly = false;
+        qsizetype MaxLineLength = 0; // in bytes, of the lines drawn so far, for the horizontal scroll bar
+
+        qsizetype LineLength(const qsizetype Line) const; // in bytes, without the line break
+        qsizetype SequenceStart(const qsizetype Line, qsizetype Column) const; // the beginning of the UTF-8 sequence at Column
+        qsizetype NextColumn(const qsizetype Line, const qsizetype Column) const; // after the code point at Column
+        QString Window(const qsizetype Line, const qsizetype Start, const qsizetype Length, qsizetype* const End = nullptr) const; // the code points in [Start, Start + Length) of the line (the last one may end later)
+        qsizetype WindowLength() const; // in bytes, enough to cover the viewport
+        qsizetype FirstVisibleLine() const;
+        qsizetype FirstVisibleColumn(const qsizetype Line) const;
+        int VisibleLineCount() const;
+        int TextWidth(const QStringView Text) const; // the tabs are expanded
+        void UpdateScrollBars();
+        void Insert(const QString& Text);
+        void RemoveBackward();
+        void RemoveForward();
+    };
+}
+
+#endif //WRITING_MATERIALS_MANAGER_LARGETEXTVIEW_H
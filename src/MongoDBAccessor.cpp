@@ -1,25 +1,99 @@
 #include "MongoDBAccessor.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <future>
+#include <mutex>
+#include <stack>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
 // mongocxx
+#include <bsoncxx/decimal128.hpp>
 #include <bsoncxx/json.hpp>
+#include <bsoncxx/types.hpp>
+
+// Qt
+#include <QDateTime>
+#include <QTimeZone>
 
 namespace WritingMaterialsManager {
-    MongoDBAccessor::MongoDBAccessor(const char* const MongoDBURI) :
-        DBURI(mongocxx::uri(MongoDBURI)),
-        Client(DBURI) {}
+    namespace {
+        using Node = QtTreeModel::Node;
+
+        QByteArrayView ToJSON(const std::string& JSON) { return QByteArrayView(JSON.data(), JSON.size()); } // already UTF-8, appended without strlen() or any conversion
+        QString ToQString(const bsoncxx::stdx::string_view String) { return QString::fromUtf8(String.data(), String.size()); }
+        QByteArray ToBytes(const bsoncxx::oid& ID) { return QByteArray(ID.bytes(), ID.size()); }
+        QDateTime ToQDateTime(const bsoncxx::types::b_date Date) {
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+            return QDateTime::fromMSecsSinceEpoch(Date.to_int64(), QTimeZone(QTimeZone::UTC)); // Qt::UTC is deprecated since Qt 6.9
+#else
+            return QDateTime::fromMSecsSinceEpoch(Date.to_int64(), Qt::UTC); // QTimeZone::UTC is new in Qt 6.5
+#endif
+        }
+    }
+
+    QString MongoDBAccessor::ObjectID::ToString() const { return QString::fromLatin1(Bytes.toHex()); }
+    QString MongoDBAccessor::Binary::ToString() const { return QString::fromLatin1(Bytes.toBase64()); }
+    QString MongoDBAccessor::Decimal128::ToString() const { return QString::fromStdString(bsoncxx::decimal128(High, Low).to_string()); }
+
+    MongoDBAccessor::MongoDBAccessor(const char* const MongoDBURI, const PoolOptions& Options) : Pool(GetPool(MongoDBURI, Options)) {}
+
+    void MongoDBAccessor::RegisterTypes() {
+        static std::once_flag Registered;
+        std::call_once(Registered, []() { // so that the views show the typed values as they show QString
+            QMetaType::registerConverter<ObjectID, QString>(&ObjectID::ToString);
+            QMetaType::registerConverter<Binary, QString>(&Binary::ToString);
+            QMetaType::registerConverter<Decimal128, QString>(&Decimal128::ToString);
+        });
+    }
+
+    std::shared_ptr<mongocxx::pool> MongoDBAccessor::GetPool(const char* const MongoDBURI, const PoolOptions& Options) {
+        // mongodb://[credentials@]hosts[/[database]][?options]
+        std::string URI = MongoDBURI;
+        const size_t Hosts = URI.find("://") == std::string::npos ? 0 : URI.find("://") + 3;
+        const size_t Query = URI.find('?', Hosts);
+        const std::string_view GivenOptions = Query == std::string::npos ? std::string_view() : std::string_view(MongoDBURI).substr(Query + 1);
+        const auto AddOption = [&](const std::string_view Key, const int Value) {
+            for (size_t Begin = 0; Begin < GivenOptions.size();) { // the names of the options are case-insensitive
+                const size_t End = std::min(GivenOptions.find_first_of("&;", Begin), GivenOptions.size());
+                const std::string_view Option = GivenOptions.substr(Begin, End - Begin);
+                const std::string_view Name = Option.substr(0, Option.find('='));
+                if (std::ranges::equal(Name, Key, [](const char a, const char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); })) { return; } // given by the URI
+                Begin = End + 1;
+            }
+            if (URI.find('?', Hosts) == std::string::npos) { URI += URI.find('/', Hosts) == std::string::npos ? "/?" : "?"; } // after the database if there's one
+            else if (URI.back() != '?' && URI.back() != '&') { URI += '&'; }
+            URI.append(Key).append("=").append(std::to_string(Value));
+        };
+        AddOption("minPoolSize", Options.MinSize);
+        AddOption("maxPoolSize", Options.MaxSize);
+
+        static std::mutex Mutex;
+        static std::unordered_map<std::string, std::shared_ptr<mongocxx::pool>> Pools; // destroyed before mongocxxDriver
+        std::lock_guard Lock(Mutex);
+        auto& Shared = Pools[URI];
+        if (Shared == nullptr) { Shared = std::make_shared<mongocxx::pool>(mongocxx::uri(URI)); } // connects lazily
+        return Shared;
+    }
 
     QByteArray MongoDBAccessor::GetDatabasesInformation() {
-        mongocxx::cursor DBInfoCur = Client.list_databases();
+        const auto Client = Pool->acquire(); // returned to the pool at the end of the scope
+        mongocxx::cursor DBInfoCur = Client->list_databases();
         QByteArray Result = "[";
         for (auto&& DBInfoDoc: DBInfoCur) {
-            Result.append(bsoncxx::to_json(DBInfoDoc).c_str()).append(", ");
+            Result.append(ToJSON(bsoncxx::to_json(DBInfoDoc))).append(", ");
         }
         Result.replace(Result.length() - 2, 2, "]");
         return Result;
     }
 
     QByteArray MongoDBAccessor::GetCollectionsInformation(const QByteArray& DatabaseName) {
-        mongocxx::database d = Client[DatabaseName.toStdString()];
+        const auto Client = Pool->acquire();
+        mongocxx::database d = (*Client)[bsoncxx::stdx::string_view(DatabaseName.constData(), DatabaseName.size())];
         return GetCollectionsInformation(d);
     }
 
@@ -27,21 +101,160 @@ namespace WritingMaterialsManager {
         mongocxx::cursor CollInfoCur = Database.list_collections();
         QByteArray Result = "[";
         for (auto&& CollInfoDoc : CollInfoCur) {
-            Result.append(bsoncxx::to_json(CollInfoDoc).c_str()).append(',');
+            Result.append(ToJSON(bsoncxx::to_json(CollInfoDoc))).append(',');
         }
-        Result.replace(Result.length() - 1, 1, "]");
-        return Result;
+        if (Result.endsWith(',')) { Result.chop(1); } // a database may have no collections
+        return Result.append(']');
     }
 
-    QByteArray MongoDBAccessor::GetDBsAndCollsInfo() {
-        mongocxx::cursor DBInfoCur = Client.list_databases();
+    QByteArray MongoDBAccessor::GetDBsAndCollsInfo(const bool WithCollections) {
+        std::vector<QByteArray> DBInfo; // the information of each database, open for its collections
+        const std::vector<std::string> DBNames = ListDatabases([&DBInfo](const bsoncxx::document::view DBInfoDoc) {
+            QByteArray Info = ToJSON(bsoncxx::to_json(DBInfoDoc)).toByteArray();
+            DBInfo.emplace_back(Info.replace(Info.length() - 1, 1, R"(, "Collections":)"));
+        });
+
+        std::vector<QByteArray> CollInfo(DBNames.size(), "null");
+        if (WithCollections) {
+            ListCollections(DBNames, [this, &CollInfo](const size_t i, mongocxx::database& Database) { CollInfo[i] = GetCollectionsInformation(Database); });
+        }
+
         QByteArray Result = "[";
+        for (size_t i = 0; i < DBInfo.size(); ++i) { // in the order of list_databases
+            if (i > 0) { Result.append(", "); }
+            Result.append(DBInfo[i]).append(CollInfo[i]).append('}');
+        }
+        return Result.append(']');
+    }
+
+    MongoDBAccessor::Tree MongoDBAccessor::GetCollectionsTree(const QByteArray& DatabaseName) {
+        const auto Client = Pool->acquire();
+        mongocxx::database d = (*Client)[bsoncxx::stdx::string_view(DatabaseName.constData(), DatabaseName.size())];
+        mongocxx::cursor CollInfoCur = d.list_collections();
+        Tree Top(new Node({ QVariant() }));
+        BuildTree(Top.get(), CollInfoCur);
+        return Top;
+    }
+
+    MongoDBAccessor::Tree MongoDBAccessor::GetDBsAndCollsTree(const bool WithCollections) {
+        Tree Top(new Node({ QVariant(), QByteArray("<Array>") }));
+        std::vector<Node*> CollInfo; // the "Collections" member of each database
+        const std::vector<std::string> DBNames = ListDatabases([&](const bsoncxx::document::view DBInfoDoc) {
+            Node* const Database = new Node({ static_cast<QtTreeModel::lsize_t>(CollInfo.size()) }, Top.get());
+            Top->PushBackChild(Database);
+            BuildTree(Database, DBInfoDoc);
+            Node* const Collections = new Node({ QStringLiteral("Collections") }, Database);
+            Database->PushBackChild(Collections);
+            CollInfo.emplace_back(Collections);
+        });
+
+        if (WithCollections) { // each worker builds the subtrees of its own databases
+            ListCollections(DBNames, [&CollInfo](const size_t i, mongocxx::database& Database) {
+                mongocxx::cursor CollInfoCur = Database.list_collections();
+                BuildTree(CollInfo[i], CollInfoCur);
+            });
+        }
+        else {
+            for (Node* const Collections: CollInfo) { Collections->PushBackData(QVariant::fromValue(nullptr)); }
+        }
+        return Top;
+    }
+
+    void MongoDBAccessor::BuildTree(Node* const Top, mongocxx::cursor& Cursor) {
+        Top->PushBackData(QByteArray("<Array>"));
+        QtTreeModel::lsize_t Index = 0;
+        for (auto&& Document: Cursor) {
+            Node* const c = new Node({ Index++ }, Top);
+            Top->PushBackChild(c);
+            BuildTree(c, Document);
+        }
+    }
+
+    void MongoDBAccessor::BuildTree(Node* const Top, const bsoncxx::document::view Document, const bool IsArray) {
+        RegisterTypes();
+        struct Container {
+            Node* Target;
+            bsoncxx::document::view Source; // an array is also a document, whose keys are the indices
+            bool IsArray;
+        };
+        std::stack<Container, std::vector<Container>> s;
+        Top->PushBackData(QByteArray(IsArray ? "<Array>" : "<Object>"));
+        s.push({ Top, Document, IsArray });
+        while (s.empty() == false) { // non-recursive DFS; the children of each container are added in order, so they needn't be reversed
+            const Container c = s.top();
+            s.pop();
+            QtTreeModel::lsize_t Index = 0;
+            for (const bsoncxx::document::element& e: c.Source) {
+                Node* const nt = new Node({ c.IsArray ? QVariant(Index++) : QVariant(ToQString(e.key())) }, c.Target);
+                c.Target->PushBackChild(nt);
+                switch (e.type()) {
+                case bsoncxx::type::k_document:
+                    nt->PushBackData(QByteArray("<Object>"));
+                    s.push({ nt, e.get_document().value, false });
+                    break;
+                case bsoncxx::type::k_array: {
+                    const bsoncxx::array::view Array = e.get_array().value;
+                    nt->PushBackData(QByteArray("<Array>"));
+                    s.push({ nt, bsoncxx::document::view(Array.data(), Array.length()), true });
+                    break;
+                }
+                case bsoncxx::type::k_double: nt->PushBackData(e.get_double().value); break;
+                case bsoncxx::type::k_utf8: nt->PushBackData(ToQString(e.get_utf8().value)); break;
+                case bsoncxx::type::k_bool: nt->PushBackData(e.get_bool().value); break;
+                case bsoncxx::type::k_int32: nt->PushBackData(e.get_int32().value); break;
+                case bsoncxx::type::k_int64: nt->PushBackData(static_cast<qint64>(e.get_int64().value)); break;
+                case bsoncxx::type::k_null: case bsoncxx::type::k_undefined: nt->PushBackData(QVariant::fromValue(nullptr)); break;
+                case bsoncxx::type::k_oid: nt->PushBackData(QVariant::fromValue(ObjectID{ ToBytes(e.get_oid().value) })); break;
+                case bsoncxx::type::k_date: nt->PushBackData(ToQDateTime(e.get_date())); break;
+                case bsoncxx::type::k_binary: {
+                    const bsoncxx::types::b_binary b = e.get_binary();
+                    nt->PushBackData(QVariant::fromValue(Binary{ static_cast<quint8>(b.sub_type), QByteArray(reinterpret_cast<const char*>(b.bytes), b.size) }));
+                    break;
+                }
+                case bsoncxx::type::k_decimal128: {
+                    const bsoncxx::decimal128 d = e.get_decimal128().value;
+                    nt->PushBackData(QVariant::fromValue(Decimal128{ d.high(), d.low() }));
+                    break;
+                }
+                // the rare types are shown as text
+                case bsoncxx::type::k_regex: nt->PushBackData(u'/' + ToQString(e.get_regex().regex) + u'/' + ToQString(e.get_regex().options)); break;
+                case bsoncxx::type::k_code: nt->PushBackData(ToQString(e.get_code().code)); break;
+                case bsoncxx::type::k_codewscope: nt->PushBackData(ToQString(e.get_codewscope().code)); break;
+                case bsoncxx::type::k_symbol: nt->PushBackData(ToQString(e.get_symbol().symbol)); break;
+                case bsoncxx::type::k_timestamp: nt->PushBackData(QStringLiteral("Timestamp(%1, %2)").arg(e.get_timestamp().timestamp).arg(e.get_timestamp().increment)); break;
+                case bsoncxx::type::k_dbpointer: nt->PushBackData(QStringLiteral("DBPointer(%1, %2)").arg(ToQString(e.get_dbpointer().collection), ObjectID{ ToBytes(e.get_dbpointer().value) }.ToString())); break;
+                case bsoncxx::type::k_minkey: nt->PushBackData(QStringLiteral("MinKey")); break;
+                case bsoncxx::type::k_maxkey: nt->PushBackData(QStringLiteral("MaxKey")); break;
+                default: nt->PushBackData(QVariant()); break; // other types are not supported.
+                }
+            }
+        }
+    }
+
+    std::vector<std::string> MongoDBAccessor::ListDatabases(const std::function<void(bsoncxx::document::view)>& Visit) {
+        std::vector<std::string> DBNames;
+        const auto Client = Pool->acquire(); // returned before the listings of the collections, which may need every client of the pool
+        mongocxx::cursor DBInfoCur = Client->list_databases();
         for (auto&& DBInfoDoc: DBInfoCur) {
-            Result.append(bsoncxx::to_json(DBInfoDoc).c_str()).replace(Result.length() - 1, 1, R"(, "Collections":)");
-            mongocxx::database Database = Client[DBInfoDoc["name"].get_utf8().value];
-            Result.append(GetCollectionsInformation(Database)).append("}, ");
+            Visit(DBInfoDoc);
+            DBNames.emplace_back(DBInfoDoc["name"].get_utf8().value);
         }
-        Result.replace(Result.length() - 2, 2, "]");
-        return Result;
+        return DBNames;
+    }
+
+    void MongoDBAccessor::ListCollections(const std::vector<std::string>& DBNames, const std::function<void(size_t, mongocxx::database&)>& Visit) {
+        if (DBNames.empty()) { return; }
+        std::atomic<size_t> Next = 0;
+        const auto List = [&]() {
+            const auto Client = Pool->acquire();
+            for (size_t i; (i = Next++) < DBNames.size();) {
+                mongocxx::database Database = (*Client)[DBNames[i]];
+                Visit(i, Database);
+            }
+        };
+        std::vector<std::future<void>> Workers; // 1 round trip for all the databases rather than 1 for each
+        for (size_t i = 0; i < std::min(DBNames.size(), MaxConcurrentListings); ++i) { Workers.emplace_back(std::async(std::launch::async, List)); }
+        for (auto& Worker: Workers) { Worker.wait(); } // all the workers are done before any exception is rethrown
+        for (auto& Worker: Workers) { Worker.get(); }
     }
 }
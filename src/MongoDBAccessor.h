@@ -1,33 +1,94 @@
 #ifndef WRITING_MATERIALS_MANAGER_MONGODBACCESSOR_H
 #define WRITING_MATERIALS_MANAGER_MONGODBACCESSOR_H
 
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
 // mongocxx
+#include <bsoncxx/document/view.hpp>
 #include <mongocxx/client.hpp>
-#include <mongocxx/uri.hpp>
 #include <mongocxx/instance.hpp>
+#include <mongocxx/pool.hpp>
+#include <mongocxx/uri.hpp>
 
 // Qt
+#include <QMetaType>
 #include <QString>
 
+#include "QtTreeModel.h"
+
 namespace WritingMaterialsManager {
+    /**
+     * The accessors of the same URI share a mongocxx::pool, so that the connections & the server discovery are set up once for the whole process.
+     * Each operation acquires a client from the pool for itself, thus an accessor can be used by multiple threads at the same time.
+     */
     class MongoDBAccessor {
     public:
         static constexpr char LocalMongoDBURI[] = "mongodb://localhost:27017/?directConnection=true&serverSelectionTimeoutMS=2000";
 
-        MongoDBAccessor(const char* const MongoDBURI = LocalMongoDBURI);
+        static constexpr size_t MaxConcurrentListings = 16; // the databases whose collections are listed at the same time, each by a client of the pool
+
+        struct PoolOptions { // ignored if the URI has minPoolSize/maxPoolSize
+            int MinSize = 0; // connections kept open to each server
+            int MaxSize = 100; // acquiring a client waits when so many are in use
+        };
+
+        // The BSON types without a counterpart in Qt, kept in the trees as typed values. Each is shown by its string, e.g., QVariant::toString().
+
+        struct ObjectID {
+            QByteArray Bytes; // 12 bytes
+            QString ToString() const; // in hex
+            bool operator==(const ObjectID&) const = default;
+        };
+
+        struct Binary {
+            quint8 Subtype = 0;
+            QByteArray Bytes;
+            QString ToString() const; // in base64, as in Extended JSON
+            bool operator==(const Binary&) const = default;
+        };
+
+        struct Decimal128 {
+            quint64 High = 0;
+            quint64 Low = 0;
+            QString ToString() const;
+            bool operator==(const Decimal128&) const = default;
+        };
+
+        using Tree = std::unique_ptr<QtTreeModel::Node>; // its value (in column 1) & its children are the result, e.g., for QtTreeModel::FromTree()
+
+        MongoDBAccessor(const char* const MongoDBURI = LocalMongoDBURI, const PoolOptions& Options = {});
         
         // return string 'cause different document DBs use different internal data structures.
 
         QByteArray GetDatabasesInformation();
         QByteArray GetCollectionsInformation(const QByteArray& DatabaseName);
-        QByteArray GetDBsAndCollsInfo();
+        QByteArray GetDBsAndCollsInfo(const bool WithCollections = true); // the collections of each database are null if they aren't listed
+
+        // The same information built from BSON directly, without a JSON text written & parsed again. BSON types are kept: a date is a QDateTime (in UTC), an int32 is an int, etc.
+
+        Tree GetCollectionsTree(const QByteArray& DatabaseName);
+        Tree GetDBsAndCollsTree(const bool WithCollections = true);
+
+        static void BuildTree(QtTreeModel::Node* const Top, const bsoncxx::document::view Document, const bool IsArray = false); // Top gets Document as its value; its key is set by the caller
     private:
         inline static const mongocxx::instance mongocxxDriver{}; // This represents the mongocxx driver instance hence should be done only once.
-        mongocxx::uri DBURI;
-        mongocxx::client Client;
+        std::shared_ptr<mongocxx::pool> Pool;
+
+        static std::shared_ptr<mongocxx::pool> GetPool(const char* const MongoDBURI, const PoolOptions& Options); // created for each URI & options at the 1st use, and kept until exit
+        static void RegisterTypes(); // the conversions of the BSON types to QString
 
         QByteArray GetCollectionsInformation(mongocxx::database& Database);
+        static void BuildTree(QtTreeModel::Node* const Top, mongocxx::cursor& Cursor); // Top gets the documents of Cursor as an array
+        std::vector<std::string> ListDatabases(const std::function<void(bsoncxx::document::view)>& Visit); // Visit each database information; returns the names in the same order
+        void ListCollections(const std::vector<std::string>& DBNames, const std::function<void(size_t, mongocxx::database&)>& Visit); // Visit(i, DBNames[i]) for all the databases, MaxConcurrentListings at a time
     };
 }
 
+Q_DECLARE_METATYPE(WritingMaterialsManager::MongoDBAccessor::ObjectID)
+Q_DECLARE_METATYPE(WritingMaterialsManager::MongoDBAccessor::Binary)
+Q_DECLARE_METATYPE(WritingMaterialsManager::MongoDBAccessor::Decimal128)
+
 #endif //WRITING_MATERIALS_MANAGER_MONGODBACCESSOR_H
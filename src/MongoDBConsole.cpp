@@ -7,11 +7,15 @@
 #include <bsoncxx/json.hpp>
 #include <bsoncxx/exception/exception.hpp>
 
+#include "StartupProfiler.h"
+#include "UTFConverter.h"
+
 namespace WritingMaterialsManager {
     MongoDBConsole::MongoDBConsole(const QString& mongoshCommand, QWidget* const Parent) : 
         DatabaseConsole(Parent), mongoshAccessor(mongoshCommandForm->text(), URLForm->text()), mongoshCommandForm(new TextField(mongoshCommand)) {
         // event handlers regarding mongosh accessor
         mongoshAccessor.moveToThread(&mongoshAccessThread); // or mongoshAccessor will run at the UI thread
+        connect(&mongoshAccessThread, &QThread::started, &mongoshAccessor, &MongoShAccessor::Start); // prior to any command queued to the thread
         connect(&mongoshAccessThread, &QThread::finished, &mongoshAccessor, &QObject::deleteLater);
         connect(ExecuteButton, &QPushButton::clicked, this, &MongoDBConsole::ExecuteShellCommand);
         connect(this, &MongoDBConsole::NewShellCommand, &mongoshAccessor, &MongoShAccessor::Execute);
@@ -75,8 +79,10 @@ namespace WritingMaterialsManager {
             Editor->RawView->textCursor().removeSelectedText();
             Editor->RawView->update(); // immediately apply the modification before text (e.g., JSON) parser reads the text from the QPlainTextEdit RawView.
             try {
-                const auto Doc = bsoncxx::from_json(Editor->RawView->toPlainText().toUtf8().constData());
-                Editor->RawView->setPlainText(QString::fromUtf8(bsoncxx::to_json(Doc, bsoncxx::ExtendedJsonMode::k_relaxed)));
+                const QByteArray UTF8 = UTFConverter::ToUTF8(Editor->RawView->toPlainText());
+                const auto Doc = bsoncxx::from_json(bsoncxx::stdx::string_view(UTF8.constData(), UTF8.size()));
+                const std::string JSON = bsoncxx::to_json(Doc, bsoncxx::ExtendedJsonMode::k_relaxed);
+                Editor->RawView->setPlainText(UTFConverter::ToUTF16(QByteArrayView(JSON.data(), JSON.size())));
                 Editor->RawView->update();
             }
             catch (const bsoncxx::exception& e) {
@@ -94,14 +100,18 @@ namespace WritingMaterialsManager {
     }
 /// ----------------------------------------------------------------
 
-    MongoShAccessor::MongoShAccessor(const QString& mongoshCommand, const QString& MongoDBURL) {
+    MongoShAccessor::MongoShAccessor(const QString& mongoshCommand, const QString& MongoDBURL) : mongoshCommand(mongoshCommand), MongoDBURL(MongoDBURL) {}
+
+    MongoShAccessor::~MongoShAccessor() {}
+
+    void MongoShAccessor::Start() {
+        const StartupProfiler::Phase Phase("mongosh start");
+        mongoshProcess = std::make_shared<QProcess>(); // created here so that it lives in the thread of this accessor
         mongoshProcess->start(mongoshCommand, { MongoDBURL });
         qDebug() << "Waiting for the start of mongoshProcess ...";
         qDebug() << (mongoshProcess->waitForStarted(-1) ? "Started." : "Start failed.");
     }
 
-    MongoShAccessor::~MongoShAccessor() {}
-
     void MongoShAccessor::SendResult() {
         using namespace std::chrono;
         using namespace std::chrono_literals;
@@ -118,6 +128,7 @@ namespace WritingMaterialsManager {
     }
 
     void MongoShAccessor::Execute(const QString& Command) {
+        if (mongoshProcess == nullptr) { Start(); } // not started by a thread
         mongoshProcess->write(Command.toUtf8());
         SendResult();
     }
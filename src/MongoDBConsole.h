@@ -27,12 +27,15 @@ namespace WritingMaterialsManager {
 
         void SendResult();
     public slots:
+        void Start(); // start mongosh in the thread of this accessor, so that the UI thread never waits for it
         void Execute(const QString& Command);
     signals:
         void MoreResult(const QString& Result);
         void NoMoreResult();
     private:
-        std::shared_ptr<QProcess> mongoshProcess = std::make_shared<QProcess>();
+        std::shared_ptr<QProcess> mongoshProcess; // created by Start()
+        QString mongoshCommand;
+        QString MongoDBURL;
     };
 
     // NOTE: MongoDBConsole doesn't have integrated TreeEditor instances.
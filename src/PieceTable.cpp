@@ -0,0 +1,201 @@
+#include "PieceTable.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace WritingMaterialsManager {
+    namespace {
+        void FindLineBreaks(const QByteArrayView Text, const qsizetype Base, std::vector<qsizetype>& Breaks) { // append the offsets (+ Base) of the line breaks in Text
+            const char* const Begin = Text.data();
+            const char* const End = Begin + Text.size();
+            for (const char* p = Begin; p < End; ++p) { // memchr() is vectorized by the C library
+                p = static_cast<const char*>(std::memchr(p, '\n', End - p));
+                if (p == nullptr) { break; }
+                Breaks.emplace_back(Base + (p - Begin));
+            }
+        }
+    }
+
+    PieceTable::PieceTable(const QByteArrayView Original, std::shared_ptr<const void> Owner) : Owner(std::move(Owner)), Original(Original) {
+        FindLineBreaks(Original, 0, OriginalBreaks);
+        if (Original.isEmpty() == false) { Root = MakeNode(Piece{ Source::Original, 0, Original.size(), static_cast<qsizetype>(OriginalBreaks.size()) }); }
+    }
+
+    qsizetype PieceTable::Size() const noexcept { return SizeOf(Root); }
+
+    void PieceTable::DetachOriginal() {
+        const auto Copy = std::make_shared<const QByteArray>(Original.toByteArray());
+        Original = *Copy; // the same bytes, so the offsets of the pieces & the line breaks still hold
+        Owner = Copy;
+    }
+
+    qsizetype PieceTable::LineCount() const noexcept { return LineBreaksOf(Root) + 1; }
+
+    qsizetype PieceTable::LineStart(qsizetype Line) const {
+        if (Line <= 0) { return 0; }
+        if (Line >= LineCount()) { return Size(); }
+        qsizetype Base = 0; // the offset of the subtree
+        for (const Node* t = Root.get(); ; ) { // find the piece with the (Line)th line break
+            if (Line <= LineBreaksOf(t->Left)) {
+                t = t->Left.get();
+                continue;
+            }
+            Line -= LineBreaksOf(t->Left);
+            Base += SizeOf(t->Left);
+            if (Line <= t->Data.LineBreaks) { // the (Line)th line break of this piece
+                const std::vector<qsizetype>& b = Breaks(t->Data.From);
+                const qsizetype Break = *(std::lower_bound(b.begin(), b.end(), t->Data.Start) + (Line - 1));
+                return Base + (Break - t->Data.Start) + 1;
+            }
+            Line -= t->Data.LineBreaks;
+            Base += t->Data.Length;
+            t = t->Right.get();
+        }
+    }
+
+    qsizetype PieceTable::LineOf(qsizetype Offset) const {
+        if (Offset <= 0) { return 0; }
+        if (Offset >= Size()) { return LineCount() - 1; }
+        qsizetype Line = 0;
+        for (const Node* t = Root.get(); ; ) {
+            if (Offset < SizeOf(t->Left)) {
+                t = t->Left.get();
+                continue;
+            }
+            Offset -= SizeOf(t->Left);
+            Line += LineBreaksOf(t->Left);
+            if (Offset < t->Data.Length) { // the line breaks before Offset in this piece
+                const std::vector<qsizetype>& b = Breaks(t->Data.From);
+                return Line + (std::lower_bound(b.begin(), b.end(), t->Data.Start + Offset) - std::lower_bound(b.begin(), b.end(), t->Data.Start));
+            }
+            Offset -= t->Data.Length;
+            Line += t->Data.LineBreaks;
+            t = t->Right.get();
+        }
+    }
+
+    QByteArray PieceTable::Line(const qsizetype Line) const {
+        if (Line < 0 || Line >= LineCount()) { return {}; }
+        const qsizetype Start = LineStart(Line);
+        const qsizetype End = Line + 1 < LineCount() ? LineStart(Line + 1) - 1 : Size();
+        return Text(Start, End - Start);
+    }
+
+    QByteArray PieceTable::Text(qsizetype Offset, qsizetype Length) const {
+        Offset = std::clamp<qsizetype>(Offset, 0, Size());
+        Length = std::clamp<qsizetype>(Length, 0, Size() - Offset);
+        QByteArray Result;
+        Result.reserve(Length);
+        Append(Result, Root.get(), Offset, Length);
+        return Result;
+    }
+
+    QByteArray PieceTable::Text() const { return Text(0, Size()); }
+
+    void PieceTable::Insert(qsizetype Offset, const QByteArrayView Text) {
+        if (Text.isEmpty()) { return; }
+        Offset = std::clamp<qsizetype>(Offset, 0, Size());
+        const qsizetype Start = Added.size();
+        Added.append(Text);
+        FindLineBreaks(Text, Start, AddedBreaks);
+        auto [Left, Right] = Split(std::move(Root), Offset);
+        if (ExtendLast(Left.get(), Start, Text.size()) == false) { Left = Merge(std::move(Left), MakeNode(MakePiece(Source::Added, Start, Text.size()))); } // typing extends the piece of the previous insertion
+        Root = Merge(std::move(Left), std::move(Right));
+    }
+
+    void PieceTable::Remove(qsizetype Offset, qsizetype Length) {
+        Offset = std::clamp<qsizetype>(Offset, 0, Size());
+        Length = std::clamp<qsizetype>(Length, 0, Size() - Offset);
+        if (Length == 0) { return; }
+        auto [Left, Rest] = Split(std::move(Root), Offset);
+        auto [Removed, Right] = Split(std::move(Rest), Length);
+        Root = Merge(std::move(Left), std::move(Right));
+    }
+
+    QByteArrayView PieceTable::View(const Piece& p) const { return (p.From == Source::Original ? Original : QByteArrayView(Added)).sliced(p.Start, p.Length); }
+
+    const std::vector<qsizetype>& PieceTable::Breaks(const Source From) const { return From == Source::Original ? OriginalBreaks : AddedBreaks; }
+
+    PieceTable::Piece PieceTable::MakePiece(const Source From, const qsizetype Start, const qsizetype Length) const {
+        const std::vector<qsizetype>& b = Breaks(From);
+        const qsizetype LineBreaks = std::lower_bound(b.begin(), b.end(), Start + Length) - std::lower_bound(b.begin(), b.end(), Start);
+        return { From, Start, Length, LineBreaks };
+    }
+
+    PieceTable::Tree PieceTable::MakeNode(const Piece& p) { return Tree(new Node{ p, static_cast<quint32>(Random()), nullptr, nullptr, p.Length, p.LineBreaks }); }
+
+    qsizetype PieceTable::SizeOf(const Tree& t) noexcept { return t ? t->Size : 0; }
+
+    qsizetype PieceTable::LineBreaksOf(const Tree& t) noexcept { return t ? t->LineBreaks : 0; }
+
+    void PieceTable::Summarize(Node& n) noexcept {
+        n.Size = SizeOf(n.Left) + n.Data.Length + SizeOf(n.Right);
+        n.LineBreaks = LineBreaksOf(n.Left) + n.Data.LineBreaks + LineBreaksOf(n.Right);
+    }
+
+    std::pair<PieceTable::Tree, PieceTable::Tree> PieceTable::Split(Tree t, const qsizetype Offset) {
+        if (t == nullptr) { return {}; }
+        const qsizetype LeftSize = SizeOf(t->Left);
+        if (Offset <= LeftSize) {
+            auto [l, r] = Split(std::move(t->Left), Offset);
+            t->Left = std::move(r);
+            Summarize(*t);
+            return { std::move(l), std::move(t) };
+        }
+        if (Offset >= LeftSize + t->Data.Length) {
+            auto [l, r] = Split(std::move(t->Right), Offset - LeftSize - t->Data.Length);
+            t->Right = std::move(l);
+            Summarize(*t);
+            return { std::move(t), std::move(r) };
+        }
+        const Piece p = t->Data; // Offset is inside this piece
+        const qsizetype InPiece = Offset - LeftSize;
+        t->Data = MakePiece(p.From, p.Start, InPiece);
+        Tree r = MakeNode(MakePiece(p.From, p.Start + InPiece, p.Length - InPiece));
+        r->Priority = t->Priority; // the right half takes the place of t above its right subtree, so the heap order holds without merging, and the shape stays random
+        r->Right = std::move(t->Right);
+        Summarize(*r);
+        Summarize(*t);
+        return { std::move(t), std::move(r) };
+    }
+
+    PieceTable::Tree PieceTable::Merge(Tree l, Tree r) {
+        if (l == nullptr) { return r; }
+        if (r == nullptr) { return l; }
+        if (l->Priority > r->Priority) {
+            l->Right = Merge(std::move(l->Right), std::move(r));
+            Summarize(*l);
+            return l;
+        }
+        r->Left = Merge(std::move(l), std::move(r->Left));
+        Summarize(*r);
+        return r;
+    }
+
+    bool PieceTable::ExtendLast(Node* const t, const qsizetype Start, const qsizetype Length) {
+        if (t == nullptr) { return false; }
+        if (t->Right ? ExtendLast(t->Right.get(), Start, Length) == false : (t->Data.From != Source::Added || t->Data.Start + t->Data.Length != Start)) { return false; }
+        if (t->Right == nullptr) { t->Data = MakePiece(Source::Added, t->Data.Start, t->Data.Length + Length); }
+        Summarize(*t);
+        return true;
+    }
+
+    void PieceTable::Append(QByteArray& Result, const Node* const t, qsizetype Offset, qsizetype Length) const {
+        if (t == nullptr || Length <= 0) { return; }
+        const qsizetype LeftSize = SizeOf(t->Left);
+        if (Offset < LeftSize) { // partly in the left subtree
+            const qsizetype n = std::min(Length, LeftSize - Offset);
+            Append(Result, t->Left.get(), Offset, n);
+            Offset += n;
+            Length -= n;
+        }
+        if (Length > 0 && Offset < LeftSize + t->Data.Length) { // partly in this piece
+            const qsizetype Begin = Offset - LeftSize;
+            const qsizetype n = std::min(Length, t->Data.Length - Begin);
+            Result.append(View(t->Data).sliced(Begin, n));
+            Offset += n;
+            Length -= n;
+        }
+        Append(Result, t->Right.get(), Offset - LeftSize - t->Data.Length, Length);
+    }
+}
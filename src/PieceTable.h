@@ -0,0 +1,137 @@
+#ifndef WRITING_MATERIALS_MANAGER_PIECETABLE_H
+#define WRITING_MATERIALS_MANAGER_PIECETABLE_H
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <QByteArray>
+
+namespace WritingMaterialsManager {
+    /**
+     * Editable UTF-8 text as a sequence of pieces of 2 buffers: the original text (e.g., a mapped file), which is never copied or modified, and an append-only buffer of the inserted text.
+     * The line breaks of both buffers are indexed, and the pieces are kept in a balanced tree (a treap) whose nodes summarize the bytes & line breaks of their subtrees,
+     * so that edits, the start of any line and the line of any offset take O(log n) time without scanning the text.
+     */
+    class PieceTable {
+    public:
+        /**
+         * @param Original The original text. It must be valid during the lifetime of this table.
+         * @param Owner Anything that keeps Original valid (e.g., the mapped file), released with this table.
+         */
+        explicit PieceTable(const QByteArrayView Original = {}, std::shared_ptr<const void> Owner = {});
+
+        qsizetype Size() const noexcept;
+        qsizetype LineCount() const noexcept; // the number of line breaks + 1
+        qsizetype LineStart(const qsizetype Line) const; // the offset of the 1st byte of the line; Size() if the line doesn't exist
+        qsizetype LineOf(const qsizetype Offset) const; // the line containing the byte at Offset
+        QByteArray Line(const qsizetype Line) const; // without the line break
+        QByteArray Text(const qsizetype Offset, const qsizetype Length) const;
+        QByteArray Text() const; // the whole text; use ForEachPiece() for large text instead
+
+        // The offsets and lengths must be at the boundaries of UTF-8 sequences.
+
+        void Insert(const qsizetype Offset, const QByteArrayView Text);
+        void Remove(const qsizetype Offset, const qsizetype Length);
+        void DetachOriginal(); // copy the original text into memory and release its Owner, e.g., before the mapped file is replaced; the pieces & the line index are kept
+
+        template<class F> void ForEachPiece(const F& Function) const { ForEachPiece(Root.get(), Function); } // Function(QByteArrayView) for each piece in order, e.g., for saving the text without materializing it
+
+        /**
+         * RapidJSON input stream over the pieces without joining them. It keeps the text of the table at its construction,
+         * so it can be read (e.g., parsed on a worker thread) while the table is edited: the appended text detaches the buffer the stream shares.
+         */
+        class Stream {
+        public:
+            using Ch = char;
+
+            explicit Stream(const PieceTable& Table) : Owner(Table.Owner), Added(Table.Added) {
+                Table.ForEachPiece([this](const QByteArrayView Piece) { if (Piece.isEmpty() == false) { Pieces.emplace_back(Piece); } });
+            }
+
+            QByteArray Text() const { // the whole text, joined
+                QByteArray Result;
+                qsizetype Size = 0;
+                for (const QByteArrayView Piece: Pieces) { Size += Piece.size(); }
+                Result.reserve(Size);
+                for (const QByteArrayView Piece: Pieces) { Result.append(Piece); }
+                return Result;
+            }
+
+            Ch Peek() const { return i < Pieces.size() ? Pieces[i][Position] : '\0'; }
+            Ch Take() {
+                if (i >= Pieces.size()) { return '\0'; }
+                const Ch c = Pieces[i][Position++];
+                if (Position == Pieces[i].size()) {
+                    Consumed += Position;
+                    Position = 0;
+                    ++i;
+                }
+                return c;
+            }
+            size_t Tell() const { return Consumed + Position; }
+
+            // in-situ parsing is not supported
+            Ch* PutBegin() { Q_ASSERT(false); return nullptr; }
+            void Put(Ch) { Q_ASSERT(false); }
+            void Flush() { Q_ASSERT(false); }
+            size_t PutEnd(Ch*) { Q_ASSERT(false); return 0; }
+        private:
+            std::shared_ptr<const void> Owner; // of the original text
+            QByteArray Added; // shared with the table until it's appended to
+            std::vector<QByteArrayView> Pieces;
+            size_t i = 0; // the current piece
+            qsizetype Position = 0;
+            size_t Consumed = 0; // bytes of the pieces before the current one
+        };
+    private:
+        enum class Source : quint8 { Original, Added, };
+
+        struct Piece {
+            Source From;
+            qsizetype Start; // in the buffer
+            qsizetype Length;
+            qsizetype LineBreaks;
+        };
+
+        std::shared_ptr<const void> Owner;
+        QByteArrayView Original;
+        QByteArray Added; // append-only
+        std::vector<qsizetype> OriginalBreaks; // offsets of the line breaks in Original
+        std::vector<qsizetype> AddedBreaks;
+
+        struct Node; // of the treap, in the order of the text
+        using Tree = std::unique_ptr<Node>;
+        struct Node {
+            Piece Data;
+            quint32 Priority; // a heap of random priorities keeps the tree balanced
+            Tree Left, Right;
+            qsizetype Size; // bytes of this subtree
+            qsizetype LineBreaks; // of this subtree
+        };
+
+        Tree Root;
+        std::minstd_rand Random;
+
+        QByteArrayView View(const Piece& p) const;
+        const std::vector<qsizetype>& Breaks(const Source From) const;
+        Piece MakePiece(const Source From, const qsizetype Start, const qsizetype Length) const; // count the line breaks of the piece
+        Tree MakeNode(const Piece& p);
+        static qsizetype SizeOf(const Tree& t) noexcept;
+        static qsizetype LineBreaksOf(const Tree& t) noexcept;
+        static void Summarize(Node& n) noexcept; // recompute the summary of n from its children
+        std::pair<Tree, Tree> Split(Tree t, const qsizetype Offset); // split the text of t at Offset; a piece across Offset is split into 2
+        static Tree Merge(Tree l, Tree r); // all the text of l is before r
+        bool ExtendLast(Node* const t, const qsizetype Start, const qsizetype Length); // extend the last piece of t by Length if it's the Added piece ending at Start
+        void Append(QByteArray& Result, const Node* const t, qsizetype Offset, qsizetype Length) const; // the text in [Offset, Offset + Length) of t
+
+        template<class F> void ForEachPiece(const Node* const t, const F& Function) const { // in order; the depth is O(log n)
+            if (t == nullptr) { return; }
+            ForEachPiece(t->Left.get(), Function);
+            Function(View(t->Data));
+            ForEachPiece(t->Right.get(), Function);
+        }
+    };
+}
+
+#endif //WRITING_MATERIALS_MANAGER_PIECETABLE_H
@@ -1,14 +1,22 @@
 #include "QtTreeModel.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
 #include <stack>
+#include <type_traits>
 #include <vector>
 
 #include <QFlags>
 #include <QLatin1StringView>
+#include <QLocale>
 #include <QVariant>
 
 #include "rapidjson/document.h"
-#include "rapidjson/pointer.h"
+
+#include "JSONLinesIndex.h"
+#include "PieceTable.h"
 
 namespace WritingMaterialsManager {
     using lsize_t = QtTreeModel::lsize_t;
@@ -28,7 +36,11 @@ namespace WritingMaterialsManager {
 
     lsize_t QtTreeModel::Node::ChildCount() const { return SubNode.count(); }
 
-    lsize_t QtTreeModel::Node::ChildNumber() const { return ParentNode != nullptr ? ParentNode->SubNode.indexOf(this) : 0; }
+    lsize_t QtTreeModel::Node::ChildNumber() const {
+        if (ParentNode == nullptr) return 0;
+        if (ParentNode->NumberedChildren) return NodalData[0].toInt(); // no linear search
+        return ParentNode->SubNode.indexOf(this);
+    }
 
     lsize_t QtTreeModel::Node::ColumnCount() const { return NodalData.count(); }
 
@@ -48,17 +60,83 @@ namespace WritingMaterialsManager {
     }
 
     void QtTreeModel::Node::PushBackChild(Node* const Child) {
+        ApplyShifts();
         SubNode.emplace_back(Child);
     }
 
+    void QtTreeModel::Node::AppendChildSlots(const lsize_t Count) {
+        ApplyShifts();
+        SubNode.resize(SubNode.size() + Count, nullptr);
+    }
+
+    bool QtTreeModel::Node::SetChild(const lsize_t Number, Node* const Child) {
+        if (Number < 0 || Number >= SubNode.size()) return false; // OOB
+        delete SubNode[Number];
+        SubNode[Number] = Child;
+        return true;
+    }
+
+    QtTreeModel::Node* QtTreeModel::Node::TakeChild(const lsize_t Number) {
+        if (Number < 0 || Number >= SubNode.size()) return nullptr; // OOB
+        ApplyShifts();
+        return SubNode.takeAt(Number);
+    }
+
+    void QtTreeModel::Node::SetNumberedChildren(const bool Numbered) { NumberedChildren = Numbered; }
+
+    void QtTreeModel::Node::AdoptChildren(Node* const From, lsize_t Position) {
+        if (Position < 0 || Position > SubNode.size()) Position = SubNode.size();
+        ApplyShifts();
+        From->ApplyShifts();
+        for (Node* const Child: qAsConst(From->SubNode)) { if (Child != nullptr) Child->ParentNode = this; }
+        SubNode.insert(Position, From->SubNode.size(), nullptr);
+        std::copy(From->SubNode.cbegin(), From->SubNode.cend(), SubNode.begin() + Position);
+        From->SubNode.clear();
+    }
+
+    QtTreeModel::Node::TextSpan& QtTreeModel::Node::Span() { return SourceSpan; }
+
+    void QtTreeModel::Node::ShiftChildren(const lsize_t First, const qsizetype Delta) {
+        if (First < 0 || First >= SubNode.size() || Delta == 0) return;
+        if (Shifts == nullptr) Shifts = std::make_unique<std::vector<qsizetype>>(SubNode.size() + 1, 0); // 1-based
+        for (qsizetype i = First + 1; i < static_cast<qsizetype>(Shifts->size()); i += i & -i) (*Shifts)[i] += Delta;
+    }
+
+    qsizetype QtTreeModel::Node::ChildStart(const lsize_t Number) const {
+        qsizetype Start = SubNode[Number]->SourceSpan.Start;
+        if (Shifts != nullptr) { for (qsizetype i = Number + 1; i > 0; i -= i & -i) Start += (*Shifts)[i]; } // the moves of the children up to Number
+        return Start;
+    }
+
+    lsize_t QtTreeModel::Node::ChildNumberBySpan(const Node* const Child) const {
+        const auto i = std::lower_bound(SubNode.cbegin(), SubNode.cend(), Child->SourceSpan.Start, [](const Node* const c, const qsizetype Start) { return c->SourceSpan.Start < Start; }); // the spans of the children are moved together, so their order is kept
+        if (i != SubNode.cend() && *i == Child) return static_cast<lsize_t>(i - SubNode.cbegin());
+        return SubNode.indexOf(Child); // e.g., the spans aren't indexed
+    }
+
+    void QtTreeModel::Node::ApplyShifts() {
+        if (Shifts == nullptr) return;
+        std::vector<qsizetype>& t = *Shifts;
+        const qsizetype Size = static_cast<qsizetype>(t.size());
+        for (qsizetype i = Size - 1; i > 0; --i) { if (i + (i & -i) < Size) t[i + (i & -i)] -= t[i]; } // back to the move at each child
+        qsizetype Shift = 0;
+        for (qsizetype i = 1; i < Size; ++i) {
+            Shift += t[i];
+            SubNode[i - 1]->SourceSpan.Start += Shift;
+        }
+        Shifts.reset();
+    }
+
     bool QtTreeModel::Node::InsertChild(lsize_t Position, Node* const Child) {
         if (Position < 0 || Position > SubNode.size()) return false;
+        ApplyShifts();
         SubNode.insert(Position, Child);
         return true;
     }
 
     bool QtTreeModel::Node::InsertChildren(const lsize_t Position, const lsize_t RowCount, const lsize_t ColumnCount) {
         if (Position < 0 || Position > SubNode.size()) return false;
+        ApplyShifts();
         const qsizetype OldSize = SubNode.size();
         for (qsizetype i = 0; i < RowCount; ++i) {
             Node* const Blank = new Node(QList<QVariant>(ColumnCount), this);
@@ -70,6 +148,7 @@ namespace WritingMaterialsManager {
 
     bool QtTreeModel::Node::RemoveChildren(const lsize_t Position, const lsize_t Count) {
         if (Position < 0 || Position + Count > SubNode.size()) return false;
+        ApplyShifts();
         for (qsizetype i = Position; i < Position + Count; ++i) delete SubNode[i];
         SubNode.remove(Position, Count);
         return true;
@@ -78,18 +157,21 @@ namespace WritingMaterialsManager {
     bool QtTreeModel::Node::InsertColumns(const lsize_t Position, const lsize_t ColumnCount) {
         if (Position < 0 || Position > NodalData.size()) return false;
         NodalData.insert(Position, ColumnCount, QVariant());
-        for (Node* CurrentChild: qAsConst(SubNode)) CurrentChild->InsertColumns(Position, ColumnCount);
+        for (Node* CurrentChild: qAsConst(SubNode)) { if (CurrentChild != nullptr) CurrentChild->InsertColumns(Position, ColumnCount); } // empty slots get the columns when they're filled
         return true;
     }
 
     bool QtTreeModel::Node::RemoveColumns(lsize_t Position, lsize_t Count) {
         if (Position < 0 || Position + Count > NodalData.size()) return false;
         NodalData.remove(Position, Count);
-        for (Node* CurrentChild: qAsConst(SubNode)) CurrentChild->RemoveColumns(Position, Count);
+        for (Node* CurrentChild: qAsConst(SubNode)) { if (CurrentChild != nullptr) CurrentChild->RemoveColumns(Position, Count); }
         return true;
     }
 
-    void QtTreeModel::Node::ReverseChild() { std::reverse(SubNode.begin(), SubNode.end()); }
+    void QtTreeModel::Node::ReverseChild() {
+        ApplyShifts();
+        std::reverse(SubNode.begin(), SubNode.end());
+    }
 
 /// class QtTreeModel
 
@@ -115,6 +197,10 @@ namespace WritingMaterialsManager {
         //if (Parent.isValid() && Parent.column() != 0) return {};
         Node* ParentItem = GetItem(Parent);
         if (ParentItem == nullptr) return {}; // ERROR: Even root node != nullptr. Hence return an invalid index
+        if (ParentItem == LazyLinesRoot) { // the record isn't parsed until its data are accessed
+            if (Row < 0 || Row >= ParentItem->ChildCount()) return {};
+            return createIndex(Row, Column, &LazyRecordTag);
+        }
         Node* TargetItem = ParentItem->Child(Row);
         if (TargetItem != nullptr) return createIndex(Row, Column, TargetItem); // index for the data item of the node queried
         return {};
@@ -122,10 +208,12 @@ namespace WritingMaterialsManager {
 
     QModelIndex QtTreeModel::parent(const QModelIndex& Index) const {
         if (Index.isValid() == false) return {};
+        if (Index.constInternalPointer() == &LazyRecordTag) return createIndex(LazyLinesRoot->ChildNumber(), 0, LazyLinesRoot); // without parsing the record
         Node* CurrentItem = GetItem(Index);
         Node* ParentItem = CurrentItem != nullptr ? CurrentItem->Parent() : nullptr;
         // top-level nodes act as entry points of trees thus return the root node as their parent is regarded illegal
         if (ParentItem == RootNode || ParentItem == nullptr) return {};
+        if (ParentItem->Parent() == LazyLinesRoot) return createIndex(ParentItem->ChildNumber(), 0, &LazyRecordTag); // the same index as index() gives
         return createIndex(ParentItem->ChildNumber(), 0, ParentItem); // return the index of the parent of the specified node
     }
 
@@ -142,10 +230,17 @@ namespace WritingMaterialsManager {
         return RootNode->ColumnCount();
     }
 
-//bool QtTreeModel::hasChildren(const QModelIndex& Parent) const {
-//    // FIXME: Implement me!
-//}
-//
+    bool QtTreeModel::hasChildren(const QModelIndex& Parent) const {
+        if (Parent.constInternalPointer() == &LazyRecordTag && LazyLinesRoot->Child(Parent.row()) == nullptr) { // guess without parsing, since the views ask this for every row
+            const QByteArrayView Record = LinesIndex->Record(Parent.row());
+            if (Record.isEmpty() || (Record.front() != '{' && Record.front() != '[')) return false;
+            qsizetype i = 1;
+            while (i < Record.size() && (Record[i] == ' ' || Record[i] == '\t' || Record[i] == '\r')) ++i; // the record has no '\n'
+            return i < Record.size() && Record[i] != (Record.front() == '{' ? '}' : ']'); // "{ }" and "[]" are empty
+        }
+        return rowCount(Parent) > 0;
+    }
+
 //bool QtTreeModel::canFetchMore(const QModelIndex& Parent) const {
 //    // FIXME: Implement me!
 //    return false;
@@ -161,13 +256,78 @@ namespace WritingMaterialsManager {
         return Item->Data(Index.column());
     }
 
+    namespace {
+        QString ToJSONText(const QVariant& Value) { // a null string if Value can't be written as JSON, e.g., a BSON type of FromTree(), whose tree is for display only
+            switch (Value.typeId()) {
+            case QMetaType::Bool: return Value.toBool() ? QStringLiteral("true") : QStringLiteral("false");
+            case QMetaType::Int: case QMetaType::LongLong: return QString::number(Value.toLongLong());
+            case QMetaType::UInt: case QMetaType::ULongLong: return QString::number(Value.toULongLong());
+            case QMetaType::Double: {
+                const double d = Value.toDouble();
+                if (qIsFinite(d) == false) return {};
+                QString Text = QString::number(d, 'g', QLocale::FloatingPointShortest);
+                if (Text.contains(u'.') == false && Text.contains(u'e') == false) { Text += u".0"; } // still parsed as a double
+                return Text;
+            }
+            case QMetaType::QString: {
+                const QString String = Value.toString();
+                QString Text(u'"');
+                Text.reserve(String.size() + 2);
+                for (const QChar c: String) {
+                    switch (c.unicode()) {
+                    case u'"': Text += u"\\\""; break;
+                    case u'\\': Text += u"\\\\"; break;
+                    case u'\b': Text += u"\\b"; break;
+                    case u'\f': Text += u"\\f"; break;
+                    case u'\n': Text += u"\\n"; break;
+                    case u'\r': Text += u"\\r"; break;
+                    case u'\t': Text += u"\\t"; break;
+                    default:
+                        if (c.unicode() < 0x20) { Text += QStringLiteral("\\u%1").arg(c.unicode(), 4, 16, QChar(u'0')); } // other control characters
+                        else { Text += c; }
+                    }
+                }
+                return Text += u'"';
+            }
+            default: return {};
+            }
+        }
+    }
+
     bool QtTreeModel::setData(const QModelIndex& Index, const QVariant& Value, int Role) {
-        if (Role != Qt::EditRole) return false;
-        Node* Item = GetItem(Index);
-//    const bool Succeeded = Item->SetData(Index.column(), Value);
-//    if (Succeeded) { emit dataChanged(Index, Index, { Qt::DisplayRole, Qt::EditRole }); }
-//    return Succeeded;
-        return false; // Direct editing on the tree model is NOT supported yet.
+        if (Role != Qt::EditRole || SpansIndexed == false) return false; // each edit is also made to the text, whose ranges are needed
+        Node* const Item = GetItem(Index);
+        if (Item == nullptr || Item == RootNode) return false;
+        for (Node* a = Item; a != RootNode; a = a->Parent()) { if (a == DirtyNode) return false; } // the text there doesn't parse now
+        Node* const Parent = Item->Parent();
+        Node::TextSpan& Span = Item->Span();
+        qsizetype Start = SpanStart(Item);
+        qsizetype Length;
+        QVariant NewValue = Value;
+        QString Text;
+        if (Index.column() == 1) { // scalar values keep their types; containers are edited in the text
+            const QVariant OldValue = Item->Data(1);
+            if (Item->ChildCount() > 0 || OldValue.typeId() == QMetaType::QByteArray || OldValue.typeId() == QMetaType::Nullptr) return false;
+            if (NewValue.typeId() != OldValue.typeId() && NewValue.convert(OldValue.metaType()) == false) return false; // e.g., a number typed as a string
+            Text = ToJSONText(NewValue);
+            if (Text.isNull()) return false;
+            Start += Span.ValueStart;
+            Length = Span.Length - Span.ValueStart;
+        }
+        else if (Index.column() == 0 && Parent != RootNode && Parent->Data(1) == QVariant(QByteArray("<Object>"))) { // the key of a member; array indices aren't editable
+            NewValue = Value.toString();
+            Text = ToJSONText(NewValue);
+            Length = Span.KeyLength;
+            Span.ValueStart += Text.size() - Length;
+            Span.KeyLength = static_cast<qint32>(Text.size());
+            Item->ShiftChildren(0, Text.size() - Length); // the spans of the children are relative to the key, which moved the value
+        }
+        else return false;
+        Item->SetData(Index.column(), NewValue);
+        ShiftSpans(Item, Text.size() - Length);
+        emit dataChanged(Index, Index, { Qt::DisplayRole, Qt::EditRole });
+        emit TextEdited(Start, Length, Text);
+        return true;
     }
 
     Qt::ItemFlags QtTreeModel::flags(const QModelIndex& Index) const {
@@ -200,6 +360,10 @@ namespace WritingMaterialsManager {
         Node* TargetItem = GetItem(Parent);
         if (TargetItem == nullptr) return false;
         beginRemoveRows(Parent, Position, Position + ChildCount - 1);
+        if (TargetItem == RootNode) { // LazyLinesRoot is a top-level node
+            ClearLazyRecords();
+            ResetTextSpans();
+        }
         const bool Succeeded = TargetItem->RemoveChildren(Position, ChildCount);
         endRemoveRows();
         return Succeeded;
@@ -215,68 +379,712 @@ namespace WritingMaterialsManager {
 
     QtTreeModel::Node* QtTreeModel::GetItem(const QModelIndex& Index) const {
         if (Index.isValid()) { // directly return the node the index queries if the given index is valid
+            if (Index.constInternalPointer() == &LazyRecordTag) { return GetRecord(Index.row()); }
             if (Index.internalPointer() != nullptr) { return static_cast<Node*>(Index.internalPointer()); }
         }
         return RootNode; // always returns the (special) root node when the given index is invalid
     }
 
-    void QtTreeModel::FromJSON(const QByteArray& UTF8JSONString) {
-        using namespace std;
-        using namespace rapidjson;
+    namespace {
+        using Node = QtTreeModel::Node;
+        using UTF16Document = rapidjson::GenericDocument<rapidjson::UTF16<char16_t>>; // char16_t instead of wchar_t, which isn't 16-bit on every platform
+
+        template<class ValueT> QString ToQString(const ValueT& String) { // the parser keeps the native encoding of the source, so strings are converted just once here
+            if constexpr (sizeof(typename ValueT::Ch) == sizeof(char)) { return QString::fromUtf8(String.GetString(), String.GetStringLength()); }
+            else { return QString(reinterpret_cast<const QChar*>(String.GetString()), String.GetStringLength()); }
+        }
+
+        template<class ValueT> void BuildTree(Node* const JSONRoot, const ValueT& Root) { // JSONRoot gets the value of Root; its name is set by the caller
+            std::stack<const ValueT*, std::vector<const ValueT*>> s; // source (source JSON)
+            std::stack<Node*, std::vector<Node*>> t;                 // target (tree structure of this model)
+            s.emplace(&Root);                                        // traversal begins at the root node of the source JSON
+            t.emplace(JSONRoot);                                     // construction begins at the root node of the target tree structure
+            while (s.empty() == false) { // non-recursive DFS
+                const ValueT* const ns = s.top();
+                s.pop();
+                Node* const nt = t.top();
+                t.pop();
+                switch (ns->GetType()) {
+                case rapidjson::kNullType: nt->PushBackData(QVariant::fromValue(nullptr)); break;
+                case rapidjson::kFalseType: case rapidjson::kTrueType: nt->PushBackData(ns->GetBool()); break;
+                case rapidjson::kStringType: nt->PushBackData(ToQString(*ns)); break;
+                case rapidjson::kNumberType:
+                    if (ns->IsUint64()) { nt->PushBackData(ns->GetUint64()); }
+                    else if (ns->IsInt64()) { nt->PushBackData(ns->GetInt64()); }
+                    else if (ns->IsDouble()) { nt->PushBackData(ns->GetDouble()); }
+                    break; // other number types are not supported.
+                case rapidjson::kArrayType:
+                    nt->PushBackData(QByteArray("<Array>"));
+                    if (ns->End() == ns->Begin()) break; // this is an empty array
+                    for (typename ValueT::ConstValueIterator i = ns->End() - 1; i >= ns->Begin(); --i) { // process the subnodes recursively (implemented by iteration)
+                        s.emplace(&*i);
+                        // Each child node c has a subscript and the corresponding value (will be added during a certain subsequent iteration).
+                        Node* const c = new Node({ i - ns->Begin() }, nt); // c's parent is nt (current node of the tree structure)
+                        nt->PushBackChild(c);
+                        t.emplace(c);
+                    }
+                    nt->ReverseChild();
+                    break;
+                case rapidjson::kObjectType:
+                    nt->PushBackData(QByteArray("<Object>"));
+                    if (ns->MemberEnd() == ns->MemberBegin()) break; // this is an empty object
+                    for (typename ValueT::ConstMemberIterator i = ns->MemberEnd() - 1; i >= ns->MemberBegin(); --i) { // process the subnodes recursively (implemented by iteration)
+                        s.emplace(&i->value);
+                        // Each child node c has the key and the corresponding value (will be added during a certain subsequent iteration).
+                        Node* const c = new Node({ ToQString(i->name) }, nt); // c's parent is nt (current node of the tree structure)
+                        nt->PushBackChild(c);
+                        t.emplace(c);
+                    }
+                    nt->ReverseChild();
+                    break;
+                }
+            }
+        }
+
+        // JSON Lines: 1 JSON value per line, blank lines are skipped
+
+        inline constexpr char JSONLinesRootName[] = "<JSON Lines Root>";
+
+        inline void Parse(rapidjson::Document& Document, const QByteArrayView Text) { Document.Parse<rapidjson::kParseFullPrecisionFlag>(Text.data(), Text.size()); }
+        class UTF16Stream { // RapidJSON input stream over a QStringView; GenericDocument::Parse(const Ch*, size_t) only reads bytes through EncodedInputStream
+        public:
+            using Ch = char16_t;
+
+            explicit UTF16Stream(const QStringView Text) : Text(Text) {}
+
+            Ch Peek() const { return Position < Text.size() ? Text[Position].unicode() : u'\0'; }
+            Ch Take() { return Position < Text.size() ? Text[Position++].unicode() : u'\0'; }
+            size_t Tell() const { return static_cast<size_t>(Position); }
+
+            // in-situ parsing is not supported
+            Ch* PutBegin() { Q_ASSERT(false); return nullptr; }
+            void Put(Ch) { Q_ASSERT(false); }
+            void Flush() { Q_ASSERT(false); }
+            size_t PutEnd(Ch*) { Q_ASSERT(false); return 0; }
+        private:
+            const QStringView Text;
+            qsizetype Position = 0;
+        };
+
+        inline void Parse(UTF16Document& Document, const QStringView Text) {
+            UTF16Stream Stream(Text);
+            Document.ParseStream<rapidjson::kParseFullPrecisionFlag>(Stream);
+        }
+        inline QString ToQString(const QByteArrayView Text) { return QString::fromUtf8(Text); }
+        inline QString ToQString(const QStringView Text) { return Text.toString(); }
+
+        template<class ViewT, class F> void ForEachLine(const ViewT Lines, const F& Function) { // Function(Line) for each non-blank line
+            using CharT = std::remove_cvref_t<decltype(Lines[0])>;
+            for (qsizetype Begin = 0; Begin < Lines.size();) {
+                qsizetype End = Lines.indexOf(CharT(u'\n'), Begin);
+                if (End < 0) { End = Lines.size(); }
+                const ViewT Line = Lines.sliced(Begin, End - Begin).trimmed();
+                if (Line.isEmpty() == false) { Function(Line); }
+                Begin = End + 1;
+            }
+        }
+
+        template<class DocumentT, class ViewT> Node* BuildRecord(Node* const LinesRoot, const lsize_t Number, const ViewT Line, DocumentT& Document) {
+            Node* const Record = new Node({ Number }, LinesRoot); // records are numbered like array elements
+            Parse(Document, Line);
+            if (Document.HasParseError()) { Record->PushBackData(ToQString(Line)); } // keep an invalid (e.g., truncated) line as raw text
+            else { BuildTree(Record, Document); }
+            return Record;
+        }
+
+        template<class DocumentT, class ViewT> void BuildLines(Node* const LinesRoot, const ViewT Lines) { // append a child to LinesRoot for each record
+            DocumentT Document; // reused by every line
+            ForEachLine(Lines, [LinesRoot, &Document](const ViewT Line) { LinesRoot->PushBackChild(BuildRecord(LinesRoot, LinesRoot->ChildCount(), Line, Document)); });
+        }
+
+        template<class ViewT> lsize_t CountLines(const ViewT Lines) {
+            lsize_t Count = 0;
+            ForEachLine(Lines, [&Count](const ViewT) { ++Count; });
+            return Count;
+        }
+    }
+
+    namespace { // binary image of the tree: each node in preorder is (quint32 child count, quint8 column count, columns), and each column is a tag followed by its payload
+        enum class ImageTag : quint8 { Invalid, Null, False, True, Int, LongLong, ULongLong, Double, String, Bytes, };
+
+        template<class T> void Write(QByteArray& Image, const T Value) { Image.append(reinterpret_cast<const char*>(&Value), sizeof(T)); } // native byte order; DocumentCache checks it
+
+        bool Write(QByteArray& Image, const QVariant& Value) {
+            using enum ImageTag;
+            switch (Value.typeId()) {
+            case QMetaType::UnknownType: Write(Image, Invalid); break;
+            case QMetaType::Nullptr: Write(Image, Null); break;
+            case QMetaType::Bool: Write(Image, Value.toBool() ? True : False); break;
+            case QMetaType::Int: Write(Image, Int); Write(Image, Value.toInt()); break;
+            case QMetaType::LongLong: Write(Image, LongLong); Write(Image, Value.toLongLong()); break;
+            case QMetaType::ULongLong: Write(Image, ULongLong); Write(Image, Value.toULongLong()); break;
+            case QMetaType::Double: Write(Image, Double); Write(Image, Value.toDouble()); break;
+            case QMetaType::QString: {
+                const QString String = Value.toString();
+                Write(Image, ImageTag::String);
+                Write(Image, static_cast<quint32>(String.size()));
+                Image.append(reinterpret_cast<const char*>(String.utf16()), String.size() * sizeof(char16_t));
+                break;
+            }
+            case QMetaType::QByteArray: {
+                const QByteArray Bytes = Value.toByteArray();
+                Write(Image, ImageTag::Bytes);
+                Write(Image, static_cast<quint32>(Bytes.size()));
+                Image.append(Bytes);
+                break;
+            }
+            default: return false; // not produced by this model
+            }
+            return true;
+        }
+
+        class ImageReader {
+        public:
+            explicit ImageReader(const QByteArrayView Image) : p(Image.data()), End(Image.data() + Image.size()) {}
+
+            bool AtEnd() const { return p == End; }
+
+            template<class T> bool Read(T& Value) {
+                if (End - p < static_cast<qsizetype>(sizeof(T))) { return false; }
+                std::memcpy(&Value, p, sizeof(T)); // the image needn't be aligned
+                p += sizeof(T);
+                return true;
+            }
+
+            bool Read(QVariant& Value) {
+                using enum ImageTag;
+                ImageTag Tag;
+                if (Read(Tag) == false) { return false; }
+                switch (Tag) {
+                case Invalid: Value = QVariant(); return true;
+                case Null: Value = QVariant::fromValue(nullptr); return true;
+                case False: Value = false; return true;
+                case True: Value = true; return true;
+                case Int: return ReadAs<int>(Value);
+                case LongLong: return ReadAs<qlonglong>(Value);
+                case ULongLong: return ReadAs<qulonglong>(Value);
+                case Double: return ReadAs<double>(Value);
+                case ImageTag::String: {
+                    quint32 Length;
+                    if (Read(Length) == false || static_cast<quint64>(End - p) < quint64(Length) * sizeof(char16_t)) { return false; }
+                    QString String(Length, Qt::Uninitialized);
+                    std::memcpy(String.data(), p, Length * sizeof(char16_t));
+                    p += Length * sizeof(char16_t);
+                    Value = std::move(String);
+                    return true;
+                }
+                case ImageTag::Bytes: {
+                    quint32 Length;
+                    if (Read(Length) == false || static_cast<quint64>(End - p) < Length) { return false; }
+                    Value = QByteArray(p, Length);
+                    p += Length;
+                    return true;
+                }
+                }
+                return false; // unknown tag
+            }
+        private:
+            const char* p;
+            const char* const End;
+
+            template<class T> bool ReadAs(QVariant& Value) {
+                T v;
+                if (Read(v) == false) { return false; }
+                Value = v;
+                return true;
+            }
+        };
+    }
+
+    QByteArray QtTreeModel::ToBinary() const {
+        if (LazyLinesRoot != nullptr) return {}; // the unparsed records have no nodes
+        QByteArray Image;
+        Write(Image, static_cast<quint32>(RootNode->ChildCount()));
+        std::stack<Node*, std::vector<Node*>> s;
+        for (lsize_t i = RootNode->ChildCount() - 1; i >= 0; --i) s.emplace(RootNode->Child(i));
+        while (s.empty() == false) { // non-recursive preorder DFS
+            Node* const n = s.top();
+            s.pop();
+            Write(Image, static_cast<quint32>(n->ChildCount()));
+            Write(Image, static_cast<quint8>(n->ColumnCount()));
+            for (lsize_t c = 0; c < n->ColumnCount(); ++c) { if (Write(Image, n->Data(c)) == false) return {}; }
+            for (lsize_t i = n->ChildCount() - 1; i >= 0; --i) s.emplace(n->Child(i));
+        }
+        return Image;
+    }
+
+    bool QtTreeModel::FromBinary(const QByteArrayView Image) {
+        ImageReader Reader(Image);
+        const std::unique_ptr<Node> Top(new Node()); // the nodes are moved to RootNode only if the whole image is valid
+        quint32 TopLevelCount;
+        if (Reader.Read(TopLevelCount) == false) return false;
+        std::stack<std::pair<Node*, quint32>, std::vector<std::pair<Node*, quint32>>> s; // (node, number of its children not read yet)
+        if (TopLevelCount > 0) s.emplace(Top.get(), TopLevelCount);
+        while (s.empty() == false) {
+            auto& [Parent, Remaining] = s.top();
+            Node* const n = new Node({}, Parent == Top.get() ? RootNode : Parent);
+            Parent->PushBackChild(n);
+            if (--Remaining == 0) s.pop(); // Parent and Remaining are dangling from now on
+            quint32 ChildCount;
+            quint8 ColumnCount;
+            if (Reader.Read(ChildCount) == false || Reader.Read(ColumnCount) == false) return false;
+            for (quint8 c = 0; c < ColumnCount; ++c) {
+                if (Reader.Read(n->PushBackData({})) == false) return false;
+            }
+            if (ChildCount > 0) s.emplace(n, ChildCount);
+        }
+        if (Reader.AtEnd() == false) return false;
+        beginResetModel();
+        ClearLazyRecords();
+        ResetTextSpans();
+        RootNode->RemoveChildren(0, RootNode->ChildCount()); // clear the extant tree nodes
+        for (lsize_t i = 0; i < Top->ChildCount(); ++i) RootNode->PushBackChild(Top->Child(i)); // move the top-level nodes to RootNode
+        while (Top->ChildCount() > 0) Top->TakeChild(Top->ChildCount() - 1); // so that they aren't deleted with Top
+        ParseErrorOffset = -1; // only valid trees are cached
+        endResetModel();
+        return true;
+    }
 
+    template<class ValueT> void QtTreeModel::ResetToJSON(const ValueT& JSONDocument) {
+        beginResetModel();
+        ClearLazyRecords();
+        ResetTextSpans();
         RootNode->RemoveChildren(0, RootNode->ChildCount()); // clear the extant tree nodes
         Node* const JSONRoot = new Node(); // new root for the unique entry of the entire tree structure
         RootNode->PushBackChild(JSONRoot); // This tree model support multiple trees, but JSON only has exactly 1 root node. Thus RootNode has just 1 child.
+        JSONRoot->PushBackData("<JSON Root>");
+        BuildTree(JSONRoot, JSONDocument);
+        endResetModel();
+    }
+
+    void QtTreeModel::FromJSON(const QByteArrayView UTF8JSONString) {
+        rapidjson::Document JSONDocument;
+        JSONDocument.Parse<rapidjson::kParseFullPrecisionFlag>(UTF8JSONString.data(), UTF8JSONString.size());
+        ParseErrorOffset = JSONDocument.HasParseError() ? static_cast<qsizetype>(JSONDocument.GetErrorOffset()) : -1;
+        ResetToJSON(JSONDocument);
+    }
 
-        Document JSONDocument;
-        JSONDocument.Parse<ParseFlag::kParseFullPrecisionFlag>(UTF8JSONString.constData());
+    void QtTreeModel::FromJSON(const QStringView UTF16JSONString) {
+        UTF16Document JSONDocument;
+        Parse(JSONDocument, UTF16JSONString);
+        ParseErrorOffset = JSONDocument.HasParseError() ? static_cast<qsizetype>(JSONDocument.GetErrorOffset()) : -1;
+        ResetToJSON(JSONDocument);
+    }
+
+    std::unique_ptr<QtTreeModel::Node> QtTreeModel::TreeFromJSON(PieceTable::Stream& Text) {
+        rapidjson::Document JSONDocument;
+        JSONDocument.ParseStream<rapidjson::kParseFullPrecisionFlag>(Text);
+        if (JSONDocument.HasParseError()) return nullptr; // e.g., in the middle of typing
+        std::unique_ptr<Node> Top(new Node({ "<JSON Root>" }));
+        BuildTree(Top.get(), JSONDocument);
+        return Top;
+    }
+
+    qsizetype QtTreeModel::GetParseErrorOffset() const { return ParseErrorOffset; }
+
+    bool QtTreeModel::SetValueFromJSON(const QModelIndex& Index, const QByteArrayView UTF8JSON) {
+        if (Index.isValid() == false || Index.constInternalPointer() == &LazyRecordTag) return false; // a lazy record is rebuilt from its line
+        rapidjson::Document Document;
+        Document.Parse<rapidjson::kParseFullPrecisionFlag>(UTF8JSON.data(), UTF8JSON.size());
+        if (Document.HasParseError()) return false;
+        const std::unique_ptr<Node> Top(new Node({ GetItem(Index)->Data(0) }));
+        BuildTree(Top.get(), Document);
+        return SetValueFromTree(Index, Top.get());
+    }
 
+    void QtTreeModel::FromTree(Node* const Value) {
         beginResetModel();
-        stack<const Value*, vector<const Value*>> s;    // source (source JSON)
-        std::stack<Node*, std::vector<Node*>> t;        // target (tree structure of this model)
-        s.emplace(Pointer("").Get(JSONDocument));       // traversal begins at the root node of the source JSON
-        JSONRoot->PushBackData("<JSON Root>");
-        t.emplace(JSONRoot);                            // construction begins at the root node of the target tree structure
-        while (s.empty() == false) { // non-recursive DFS
-            const Value* const ns = s.top();
-            s.pop();
-            Node* const nt = t.top();
-            t.pop();
-            switch (ns->GetType()) {
-            case kNullType: nt->PushBackData(QVariant::fromValue(nullptr)); break;
-            case kFalseType: case kTrueType: nt->PushBackData(ns->GetBool()); break;
-            case kStringType: nt->PushBackData(ns->GetString()); break;
-            case kNumberType:
-                if (ns->IsUint64()) { nt->PushBackData(ns->GetUint64()); }
-                else if (ns->IsInt64()) { nt->PushBackData(ns->GetInt64()); }
-                else if (ns->IsDouble()) { nt->PushBackData(ns->GetDouble()); }
-                break; // other number types are not supported.
-            case kArrayType:
-                nt->PushBackData(QByteArray("<Array>"));
-                if (ns->End() == ns->Begin()) break; // this is an empty array
-                for (Value::ConstValueIterator i = ns->End() - 1; i >= ns->Begin(); --i) { // process the subnodes recursively (implemented by iteration)
-                    s.emplace(&*i);
-                    // Each child node c has a subscript and the corresponding value (will be added during a certain subsequent iteration).
-                    Node* const c = new Node({ i - ns->Begin() }, nt); // c's parent is nt (current node of the tree structure)
-                    nt->PushBackChild(c);
-                    t.emplace(c);
+        ClearLazyRecords();
+        ResetTextSpans();
+        RootNode->RemoveChildren(0, RootNode->ChildCount()); // clear the extant tree nodes
+        Node* const JSONRoot = new Node({ "<JSON Root>", Value->Data(1) }, RootNode);
+        RootNode->PushBackChild(JSONRoot);
+        JSONRoot->AdoptChildren(Value);
+        ParseErrorOffset = -1; // nothing is parsed
+        endResetModel();
+    }
+
+    bool QtTreeModel::SetValueFromTree(const QModelIndex& Index, Node* const Value) {
+        if (Index.isValid() == false || Index.constInternalPointer() == &LazyRecordTag) return false; // a lazy record is rebuilt from its line
+        Node* const n = GetItem(Index);
+        ResetTextSpans(); // the tree doesn't match the indexed text anymore
+        const QModelIndex Parent = Index.siblingAtColumn(0);
+        if (n->ChildCount() > 0) {
+            beginRemoveRows(Parent, 0, n->ChildCount() - 1);
+            n->RemoveChildren(0, n->ChildCount());
+            endRemoveRows();
+        }
+        n->SetData(1, Value->Data(1));
+        if (Value->ChildCount() > 0) {
+            beginInsertRows(Parent, 0, Value->ChildCount() - 1);
+            n->AdoptChildren(Value);
+            endInsertRows();
+        }
+        emit dataChanged(Parent, Parent.siblingAtColumn(1), { Qt::DisplayRole, Qt::EditRole });
+        return true;
+    }
+
+    template<class DocumentT, class ViewT> void QtTreeModel::ResetToJSONLines(const ViewT Lines) {
+        beginResetModel();
+        ClearLazyRecords();
+        ResetTextSpans();
+        RootNode->RemoveChildren(0, RootNode->ChildCount()); // clear the extant tree nodes
+        Node* const LinesRoot = new Node({ JSONLinesRootName, QByteArray("<Array>") }, RootNode); // the records are shown like an array
+        LinesRoot->SetNumberedChildren(true);
+        RootNode->PushBackChild(LinesRoot);
+        BuildLines<DocumentT>(LinesRoot, Lines);
+        endResetModel();
+    }
+
+    template<class DocumentT, class ViewT> void QtTreeModel::AppendToJSONLines(const ViewT Lines) {
+        Node* const LinesRoot = RootNode->Child(0);
+        if (LinesRoot == nullptr || LinesRoot->Data(0).toString() != JSONLinesRootName) { // not JSON Lines yet
+            ResetToJSONLines<DocumentT>(Lines);
+            return;
+        }
+        const lsize_t Count = CountLines(Lines);
+        if (Count == 0) { return; }
+        const lsize_t First = LinesRoot->ChildCount();
+        beginInsertRows(createIndex(0, 0, LinesRoot), First, First + Count - 1); // only the new rows are announced, so the views keep their states
+        BuildLines<DocumentT>(LinesRoot, Lines);
+        endInsertRows();
+    }
+
+    void QtTreeModel::FromJSONLines(const QByteArrayView UTF8JSONLines) { ResetToJSONLines<rapidjson::Document>(UTF8JSONLines); }
+    void QtTreeModel::FromJSONLines(const QStringView UTF16JSONLines) { ResetToJSONLines<UTF16Document>(UTF16JSONLines); }
+    void QtTreeModel::FromJSONLines(const std::shared_ptr<const JSONLinesIndex>& Index) {
+        beginResetModel();
+        ClearLazyRecords();
+        ResetTextSpans();
+        RootNode->RemoveChildren(0, RootNode->ChildCount()); // clear the extant tree nodes
+        LazyLinesRoot = new Node({ JSONLinesRootName, QByteArray("<Array>") }, RootNode);
+        LazyLinesRoot->SetNumberedChildren(true);
+        LazyLinesRoot->AppendChildSlots(static_cast<lsize_t>(std::min<qsizetype>(Index->Count(), std::numeric_limits<lsize_t>::max())));
+        RootNode->PushBackChild(LazyLinesRoot);
+        LinesIndex = Index;
+        endResetModel();
+    }
+
+    std::shared_ptr<const JSONLinesIndex> QtTreeModel::GetJSONLinesIndex() const { return LinesIndex; }
+
+    bool QtTreeModel::RebaseJSONLines(const std::shared_ptr<const JSONLinesIndex>& Index) {
+        if (LinesIndex == nullptr || Index == nullptr || Index->GetText() != LinesIndex->GetText()) return false;
+        LinesIndex = Index; // the records are at the same offsets, so the parsed ones are kept
+        return true;
+    }
+
+    QtTreeModel::Node* QtTreeModel::GetRecord(const lsize_t Row) const {
+        Node* Record = LazyLinesRoot->Child(Row);
+        if (Record != nullptr || Row < 0 || Row >= LazyLinesRoot->ChildCount()) return Record; // parsed, or OOB
+        rapidjson::Document Document;
+        Record = BuildRecord(LazyLinesRoot, Row, LinesIndex->Record(Row), Document);
+        LazyLinesRoot->SetChild(Row, Record);
+        return Record;
+    }
+
+    void QtTreeModel::ClearLazyRecords() {
+        LazyLinesRoot = nullptr; // deleted with the other children of RootNode
+        LinesIndex.reset();
+    }
+
+    void QtTreeModel::AppendJSONLines(const QByteArrayView UTF8JSONLines) { AppendToJSONLines<rapidjson::Document>(UTF8JSONLines); }
+    void QtTreeModel::AppendJSONLines(const QStringView UTF16JSONLines) { AppendToJSONLines<UTF16Document>(UTF16JSONLines); }
+
+    namespace {
+        inline bool IsContainer(const QtTreeModel::Node* const n) { return n->Data(1).typeId() == QMetaType::QByteArray; } // "<Array>" or "<Object>"
+
+        class SpanScanner { // assign the text spans of a subtree by scanning the (valid) JSON it was built from, without parsing the values again
+        public:
+            explicit SpanScanner(const QStringView Text) : Text(Text) {}
+
+            bool Scan(Node* const Root) { // the start of Root is its absolute position in Text; returns false if the structure of Text doesn't match the subtree
+                struct Frame {
+                    Node* Container;
+                    qsizetype Start; // of the span of Container
+                    lsize_t Next; // the next child
+                    QChar Close;
+                };
+                std::vector<Frame> s;
+                SkipSpace();
+                Root->Span() = { p, 0, 0, 0 };
+                Node* n = Root; // the node whose value begins at p
+                qsizetype Start = p; // the start of the span of n
+                while (true) { // non-recursive DFS
+                    if (n != nullptr) {
+                        if (p >= Text.size()) return false;
+                        if (Text[p] == u'{' || Text[p] == u'[') {
+                            n->ApplyShifts(); // the spans of the children are overwritten
+                            s.push_back({ n, Start, 0, Text[p] == u'{' ? u'}' : u']' });
+                        }
+                        else if (Text[p] == u'"' ? SkipString() == false : SkipScalar() == false) return false;
+                        if (s.empty() || s.back().Container != n) { n->Span().Length = p - Start; }
+                        else { ++p; } // after the opening bracket
+                        n = nullptr;
+                    }
+                    if (s.empty()) return true;
+                    Frame& f = s.back();
+                    SkipSpace();
+                    if (p >= Text.size()) return false;
+                    if (Text[p] == f.Close) {
+                        if (f.Next != f.Container->ChildCount()) return false;
+                        f.Container->Span().Length = ++p - f.Start;
+                        s.pop_back();
+                        continue;
+                    }
+                    if (f.Next > 0) {
+                        if (Text[p] != u',') return false;
+                        ++p;
+                        SkipSpace();
+                    }
+                    n = f.Container->Child(f.Next++);
+                    if (n == nullptr) return false;
+                    Start = p;
+                    n->Span() = { p - f.Start, 0, 0, 0 };
+                    if (f.Close == u'}') { // the key begins the span of a member
+                        if (p >= Text.size() || Text[p] != u'"' || SkipString() == false) return false;
+                        n->Span().KeyLength = static_cast<qint32>(p - Start);
+                        SkipSpace();
+                        if (p >= Text.size() || Text[p] != u':') return false;
+                        ++p;
+                        SkipSpace();
+                        n->Span().ValueStart = static_cast<qint32>(p - Start);
+                    }
                 }
-                nt->ReverseChild();
-                break;
-            case kObjectType:
-                nt->PushBackData(QByteArray("<Object>"));
-                if (ns->MemberEnd() == ns->MemberBegin()) break; // this is an empty object
-                for (Value::ConstMemberIterator i = ns->MemberEnd() - 1; i >= ns->MemberBegin(); --i) { // process the subnodes recursively (implemented by iteration)
-                    s.emplace(&i->value);
-                    // Each child node c has the key and the corresponding value (will be added during a certain subsequent iteration).
-                    Node* const c = new Node({ i->name.GetString() }, nt); // c's parent is nt (current node of the tree structure)
-                    nt->PushBackChild(c);
-                    t.emplace(c);
+            }
+        private:
+            const QStringView Text;
+            qsizetype p = 0;
+
+            void SkipSpace() { while (p < Text.size() && (Text[p] == u' ' || Text[p] == u'\n' || Text[p] == u'\r' || Text[p] == u'\t')) ++p; }
+            bool SkipString() { // p is at the opening quote
+                for (++p; p < Text.size(); ++p) {
+                    if (Text[p] == u'\\') { ++p; }
+                    else if (Text[p] == u'"') {
+                        ++p;
+                        return true;
+                    }
                 }
-                nt->ReverseChild();
-                break;
+                return false;
             }
+            bool SkipScalar() { // numbers & literals
+                const qsizetype Begin = p;
+                while (p < Text.size() && QStringView(u",]} \n\r\t").contains(Text[p]) == false) ++p;
+                return p > Begin;
+            }
+        };
+    }
+
+    bool QtTreeModel::IndexTextSpans(const QStringView Text) {
+        ResetTextSpans();
+        if (LazyLinesRoot != nullptr || RootNode->ChildCount() != 1 || RootNode->Child(0)->Data(0).toString() == JSONLinesRootName) return false;
+        SpansIndexed = SpanScanner(Text).Scan(RootNode->Child(0));
+        return SpansIndexed;
+    }
+
+    bool QtTreeModel::SyncTextEdit(const qsizetype Position, const qsizetype Removed, const qsizetype Added, const std::function<QString(qsizetype, qsizetype)>& Text) {
+        if (SpansIndexed == false) return false;
+        Node* const JSONRoot = RootNode->Child(0);
+        const qsizetype End = Position + Removed; // in the text before the edit
+        const qsizetype Delta = Added - Removed;
+        const qsizetype RootStart = JSONRoot->Span().Start, RootEnd = RootStart + JSONRoot->Span().Length;
+        const bool RootDirty = DirtyNode == JSONRoot && DirtyFirst < 0; // the span of the root value is stale too
+        if (RootDirty == false && (End <= RootStart || Position >= RootEnd) && Text(Position, Added).trimmed().isEmpty()) { // spaces outside the root value
+            if (End <= RootStart) JSONRoot->Span().Start += Delta;
+            return DirtyNode == nullptr;
         }
-        endResetModel();
+        if (RootDirty || IsContainer(JSONRoot) == false || Position <= RootStart || End >= RootEnd) { // the brackets of the root value may be edited
+            if (Reparse(JSONRoot, 0, -1, Text)) return true;
+            MarkDirty(JSONRoot, -1, 0);
+            return false;
+        }
+        Node* n = JSONRoot; // the smallest container enclosing the edit between its brackets, whose spans are up to date
+        qsizetype Start = RootStart; // of n
+        while (true) { // binary search among the children, whose spans are in order
+            lsize_t Low = 0, High = n->ChildCount();
+            while (Low < High) {
+                const lsize_t Middle = (Low + High) / 2;
+                if (Start + n->ChildStart(Middle) <= Position) Low = Middle + 1;
+                else High = Middle;
+            }
+            if (Low == 0) break;
+            if (n == DirtyNode && Low - 1 >= DirtyFirst && Low - 1 < DirtyFirst + DirtyCount) break; // its span is stale
+            Node* const c = n->Child(Low - 1);
+            const qsizetype ChildStart = Start + n->ChildStart(Low - 1);
+            if (IsContainer(c) == false || Position <= ChildStart + c->Span().ValueStart || End >= ChildStart + c->Span().Length) break; // the edits of the key, of the brackets or around c are patched in n
+            Start = ChildStart;
+            n = c;
+        }
+        ShiftSpans(n, Delta);
+        return ReparseChildren(n, Start, Position, End, Delta, Text);
+    }
+
+    void QtTreeModel::ResetTextSpans() {
+        SpansIndexed = false;
+        DirtyNode = nullptr;
+    }
+
+    QModelIndex QtTreeModel::IndexOf(Node* const n) const {
+        if (n == RootNode) return QModelIndex();
+        return createIndex(SpansIndexed ? n->Parent()->ChildNumberBySpan(n) : n->ChildNumber(), 0, n);
+    }
+
+    qsizetype QtTreeModel::SpanStart(Node* n) const {
+        qsizetype Start = 0;
+        for (; n != RootNode; n = n->Parent()) Start += n->Parent()->ChildStart(n->Parent()->ChildNumberBySpan(n));
+        return Start;
+    }
+
+    void QtTreeModel::ShiftSpans(Node* const n, const qsizetype Delta) {
+        if (Delta == 0) return;
+        for (Node* c = n; c != RootNode; c = c->Parent()) {
+            c->Span().Length += Delta;
+            Node* const Parent = c->Parent();
+            Parent->ShiftChildren(Parent->ChildNumberBySpan(c) + 1, Delta); // relative to Parent, so the descendants needn't move
+        }
+    }
+
+    bool QtTreeModel::ReparseChildren(Node* const n, const qsizetype Start, const qsizetype Position, const qsizetype End, const qsizetype Delta, const std::function<QString(qsizetype, qsizetype)>& Text) {
+        const lsize_t Count = n->ChildCount();
+        const auto ChildEnd = [n](const lsize_t i) { return n->ChildStart(i) + n->Child(i)->Span().Length; };
+        lsize_t Low = 0, High = Count; // the children touched by the edit, in the spans before it; a scalar touched at either end may change too, e.g., by a digit typed after a number
+        while (Low < High) {
+            const lsize_t Middle = (Low + High) / 2;
+            if (Start + ChildEnd(Middle) < Position) Low = Middle + 1;
+            else High = Middle;
+        }
+        if (Low < Count && Start + ChildEnd(Low) == Position && IsContainer(n->Child(Low))) ++Low; // after the closing bracket
+        lsize_t First = Low;
+        High = Count;
+        while (Low < High) {
+            const lsize_t Middle = (Low + High) / 2;
+            if (Start + n->ChildStart(Middle) <= End) Low = Middle + 1;
+            else High = Middle;
+        }
+        if (Low > First && Start + n->ChildStart(Low - 1) == End && IsContainer(n->Child(Low - 1))) --Low; // before the key or the opening bracket
+        lsize_t Past = Low;
+        if (n == DirtyNode) { // the children which didn't parse are parsed together
+            First = std::min(First, DirtyFirst);
+            Past = std::max(Past, DirtyFirst + DirtyCount);
+        }
+        n->ShiftChildren(Past, Delta);
+
+        // The text between the neighbors of the children is parsed in place of them, with a filler for each neighbor, so that the commas are checked too. Spaces typed between 2 children only move the spans.
+        const bool Object = n->Data(1) == QVariant(QByteArray("<Object>"));
+        const qsizetype SegmentStart = First > 0 ? ChildEnd(First - 1) : n->Span().ValueStart + 1; // after the previous neighbor or the opening bracket
+        const qsizetype SegmentEnd = Past < Count ? n->ChildStart(Past) : n->Span().Length - 1; // before the next neighbor or the closing bracket
+        const QString Filler = Object ? QStringLiteral("\"\":0") : QStringLiteral("0");
+        const QString Prefix = QString(Object ? u'{' : u'[') + (First > 0 ? Filler : QString());
+        const QString Source = Prefix + Text(Start + SegmentStart, SegmentEnd - SegmentStart) + (Past < Count ? Filler : QString()) + (Object ? u'}' : u']');
+        UTF16Document Document;
+        Parse(Document, Source);
+        const std::unique_ptr<Node> Top(new Node({ n->Data(0) }));
+        if (Document.HasParseError() == false) BuildTree(Top.get(), Document);
+        if (Document.HasParseError() || SpanScanner(Source).Scan(Top.get()) == false || Top->ChildCount() < (First > 0) + (Past < Count)) {
+            MarkDirty(n, First, Past);
+            return false;
+        }
+        if (DirtyNode == n) { DirtyNode = nullptr; }
+        else if (DirtyNode != nullptr) { // it's patched if it's below the children
+            Node* a = DirtyNode;
+            while (a->Parent() != RootNode && a->Parent() != n) a = a->Parent();
+            if (a->Parent() == n && n->ChildNumberBySpan(a) >= First && n->ChildNumberBySpan(a) < Past) DirtyNode = nullptr;
+        }
+        if (First > 0) delete Top->TakeChild(0);
+        if (Past < Count) delete Top->TakeChild(Top->ChildCount() - 1);
+        const lsize_t NewCount = Top->ChildCount();
+        for (lsize_t i = 0; i < NewCount; ++i) {
+            Node* const c = Top->Child(i);
+            c->Span().Start += SegmentStart - Prefix.size(); // relative to n
+            if (Object == false) c->SetData(0, static_cast<qsizetype>(First + i));
+        }
+
+        if (NewCount == 1 && Past - First == 1 && Top->Child(0)->ChildCount() == 0 && n->Child(First)->ChildCount() == 0 && Top->Child(0)->Span().Start == n->ChildStart(First)) { // e.g., a character typed in a string: the row is kept
+            Node* const c = n->Child(First);
+            Node* const Built = Top->Child(0);
+            const qsizetype StoredStart = c->Span().Start; // without the moves
+            c->Span() = Built->Span();
+            c->Span().Start = StoredStart;
+            c->SetData(0, Built->Data(0));
+            c->SetData(1, Built->Data(1));
+            emit dataChanged(createIndex(First, 0, c), createIndex(First, 1, c), { Qt::DisplayRole, Qt::EditRole });
+            return true;
+        }
+        const QModelIndex Index = IndexOf(n);
+        if (Past > First) {
+            beginRemoveRows(Index, First, Past - 1);
+            n->RemoveChildren(First, Past - First);
+            endRemoveRows();
+        }
+        if (NewCount > 0) {
+            beginInsertRows(Index, First, First + NewCount - 1);
+            n->AdoptChildren(Top.get(), First);
+            endInsertRows();
+        }
+        if (Object == false && NewCount != Past - First && First + NewCount < n->ChildCount()) { // the indices of the following elements
+            for (lsize_t i = First + NewCount; i < n->ChildCount(); ++i) n->Child(i)->SetData(0, static_cast<qsizetype>(i));
+            emit dataChanged(createIndex(First + NewCount, 0, n->Child(First + NewCount)), createIndex(n->ChildCount() - 1, 0, n->Child(n->ChildCount() - 1)), { Qt::DisplayRole, Qt::EditRole });
+        }
+        return true;
+    }
+
+    void QtTreeModel::MarkDirty(Node* n, lsize_t First, lsize_t Past) {
+        if (First >= 0 && DirtyNode != nullptr && DirtyNode != n) { // another value doesn't parse either: the children of their lowest common ancestor between them are parsed together
+            std::vector<Node*> DirtyPath;
+            for (Node* a = DirtyNode; a != RootNode; a = a->Parent()) DirtyPath.emplace_back(a);
+            Node* Below = nullptr; // the child of n on the way to the edit
+            while (std::find(DirtyPath.cbegin(), DirtyPath.cend(), n) == DirtyPath.cend()) {
+                Below = n;
+                n = n->Parent();
+            }
+            if (Below != nullptr) {
+                First = n->ChildNumberBySpan(Below);
+                Past = First + 1;
+            }
+            if (n == DirtyNode) {
+                First = std::min(First, DirtyFirst);
+                Past = std::max(Past, DirtyFirst + DirtyCount);
+            }
+            else {
+                const lsize_t Row = n->ChildNumberBySpan(*(std::find(DirtyPath.cbegin(), DirtyPath.cend(), n) - 1)); // the child of n on the way to DirtyNode
+                First = std::min(First, Row);
+                Past = std::max(Past, Row + 1);
+            }
+        }
+        DirtyNode = n;
+        DirtyFirst = First;
+        DirtyCount = Past - First;
+    }
+
+    bool QtTreeModel::Reparse(Node* const n, const qsizetype Start, const qsizetype Length, const std::function<QString(qsizetype, qsizetype)>& Text) {
+        Node* const Parent = n->Parent();
+        const bool IsMember = Parent != RootNode && Parent->Data(1) == QVariant(QByteArray("<Object>"));
+        const QString Source = IsMember ? u'{' + Text(Start, Length) + u'}' : Text(Start, Length); // a member is parsed as an object of itself
+        UTF16Document Document;
+        Parse(Document, Source);
+        if (Document.HasParseError() || (IsMember && Document.MemberCount() != 1)) return false;
+        const std::unique_ptr<Node> Top(new Node({ n->Data(0) }));
+        BuildTree(Top.get(), Document);
+        if (SpanScanner(Source).Scan(Top.get()) == false) return false;
+        Node* const Built = IsMember ? Top->Child(0) : Top.get();
+        Node::TextSpan Span = Built->Span();
+        Span.Start = Start - SpanStart(Parent) + (IsMember ? Span.Start - 1 : Span.Start); // the spaces before the value are skipped; the brace before the member isn't in the text
+        const QModelIndex Index = IndexOf(n);
+        if (n->ChildCount() > 0) {
+            beginRemoveRows(Index, 0, n->ChildCount() - 1);
+            n->RemoveChildren(0, n->ChildCount());
+            endRemoveRows();
+        }
+        DirtyNode = nullptr; // it's n or a descendant of n
+        if (IsMember) n->SetData(0, Built->Data(0)); // the key may be edited
+        n->SetData(1, Built->Data(1));
+        Parent->ApplyShifts(); // the span of n is set without the moves
+        n->Span() = Span;
+        if (Built->ChildCount() > 0) {
+            beginInsertRows(Index, 0, Built->ChildCount() - 1);
+            n->AdoptChildren(Built);
+            endInsertRows();
+        }
+        emit dataChanged(Index, Index.siblingAtColumn(1), { Qt::DisplayRole, Qt::EditRole });
+        return true;
     }
 }
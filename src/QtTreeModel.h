@@ -1,9 +1,17 @@
 #ifndef WRITING_MATERIALS_MANAGER_QTTREEMODEL_H
 #define WRITING_MATERIALS_MANAGER_QTTREEMODEL_H
 
+#include <functional>
+#include <memory>
+#include <vector>
+
 #include <QAbstractItemModel>
 
+#include "PieceTable.h"
+
 namespace WritingMaterialsManager {
+    class JSONLinesIndex;
+
     class QtTreeModel : public QAbstractItemModel {
     Q_OBJECT
     public:
@@ -11,6 +19,13 @@ namespace WritingMaterialsManager {
 
         class Node {
         public:
+            struct TextSpan { // the range of a node in the text it was built from (in UTF-16 code units), for syncing the edits of either side
+                qsizetype Start = 0; // relative to the start of the parent
+                qsizetype Length = 0;
+                qint32 KeyLength = 0; // of the key of an object member, which begins the range
+                qint32 ValueStart = 0; // relative to Start
+            };
+
             /**
              * Initially, each node has no children. They're added using the InsertChildren() function.
              * @param Data
@@ -41,6 +56,27 @@ namespace WritingMaterialsManager {
             QVariant Data(lsize_t Column) const;
             void PushBackChild(Node* const Child);
 
+            /**
+             * Append empty slots for children created on demand (e.g., the records of a huge JSON Lines file). Child() returns nullptr for an empty slot until SetChild() fills it.
+             * @param Count The number of slots.
+             */
+            void AppendChildSlots(lsize_t Count);
+            bool SetChild(lsize_t Number, Node* const Child); // fill an empty slot; the existing child is deleted
+            Node* TakeChild(lsize_t Number); // remove the child from this node without deleting it
+            void SetNumberedChildren(const bool Numbered); // the 1st data of each child is its child number, so ChildNumber() needn't search among (maybe millions of) siblings
+            void AdoptChildren(Node* const From, lsize_t Position = -1); // move all the children of From before the child at Position (after the children of this node if Position < 0)
+            TextSpan& Span();
+
+            /**
+             * Move the spans of the children from First on by Delta, e.g., after an edit before them. The moves are summed in a Fenwick tree instead of being added to each span, so an edit takes O(log n) time at each level rather than O(siblings).
+             * @param First The No. of the 1st child to move.
+             * @param Delta
+             */
+            void ShiftChildren(lsize_t First, qsizetype Delta);
+            qsizetype ChildStart(lsize_t Number) const; // the start of the span of the child relative to this node, with the moves
+            lsize_t ChildNumberBySpan(const Node* const Child) const; // ChildNumber() by a binary search among the spans, which are in order; for the nodes of the indexed text
+            void ApplyShifts(); // add the moves to the spans of the children; done before the children are inserted or removed
+
             /**
              * Insert a subnode for this node.
              * @param Position The position of insertion. The existing element at Position will be moved to (Position + RowCount).
@@ -113,6 +149,9 @@ namespace WritingMaterialsManager {
             QList<Node*> SubNode;
             QList<QVariant> NodalData;
             Node* ParentNode;
+            bool NumberedChildren = false;
+            TextSpan SourceSpan;
+            std::unique_ptr<std::vector<qsizetype>> Shifts; // the Fenwick tree of ShiftChildren(), created by the 1st move
         };
 
         // The name of each column is stored at the root node. The entry point of each tree is the child of the root node
@@ -164,7 +203,7 @@ namespace WritingMaterialsManager {
 
         // Fetch data dynamically:
 
-        //bool hasChildren(const QModelIndex& Parent = QModelIndex()) const override;
+        bool hasChildren(const QModelIndex& Parent = QModelIndex()) const override; // an unparsed record of the JSON Lines index is judged by its 1st character
 
         //bool canFetchMore(const QModelIndex& Parent) const override;
         //void fetchMore(const QModelIndex& Parent) override;
@@ -194,10 +233,84 @@ namespace WritingMaterialsManager {
 
         // custom functions
 
-        void FromJSON(const QByteArray& UTF8JSONString); // construct this tree model from JSON
+        void FromJSON(const QByteArrayView UTF8JSONString); // construct this tree model from JSON; the text needn't be null-terminated (e.g., a mapped file)
+        void FromJSON(const QStringView UTF16JSONString); // construct this tree model from JSON already decoded for display, without re-encoding it to UTF-8
+        static std::unique_ptr<Node> TreeFromJSON(PieceTable::Stream& Text); // build a tree for FromTree() from edited text (e.g., of LargeTextView) without joining its pieces; nullptr if it doesn't parse. No model is touched, so it can run on a worker thread
+        void FromJSONLines(const QByteArrayView UTF8JSONLines); // construct this tree model from JSON Lines (NDJSON): each line is a record under the unique top-level node
+        void FromJSONLines(const QStringView UTF16JSONLines);
+        void FromJSONLines(const std::shared_ptr<const JSONLinesIndex>& Index); // construct this tree model from indexed JSON Lines: each record is parsed when it's accessed for the 1st time
+        std::shared_ptr<const JSONLinesIndex> GetJSONLinesIndex() const; // of FromJSONLines(), or nullptr
+        bool RebaseJSONLines(const std::shared_ptr<const JSONLinesIndex>& Index); // replace the index of FromJSONLines() with one of the same text (e.g., a copy in memory, or the file it's saved to) without a reset; false if the text differs
+        void AppendJSONLines(const QByteArrayView UTF8JSONLines); // append records after the existing ones as new rows; the lines must be complete
+        void AppendJSONLines(const QStringView UTF16JSONLines);
+
+        /**
+         * Serialize the tree into a compact binary image (for DocumentCache), which is rebuilt without parsing.
+         * @return The image, or an empty one if the tree can't be serialized (e.g., records of JSON Lines which haven't been parsed, or values of FromTree() with no JSON form).
+         */
+        QByteArray ToBinary() const;
+        bool FromBinary(const QByteArrayView Image); // rebuild the tree from an image of ToBinary(); returns false and keeps this model unchanged if the image is corrupted
+        qsizetype GetParseErrorOffset() const; // the offset (in code units of the text) of the syntax error found by the last FromJSON(), or -1 if there's none
+
+        /**
+         * Replace the value (i.e., the subtree) of a node with JSON, e.g., a placeholder with the data loaded later. The key of the node is kept, and the rows of the other nodes are untouched.
+         * @param Index The node.
+         * @param UTF8JSON The new value.
+         * @return Whether the value was replaced. If JSON is invalid, the node is unchanged.
+         */
+        bool SetValueFromJSON(const QModelIndex& Index, const QByteArrayView UTF8JSON);
+
+        /**
+         * Construct this tree model from a tree built elsewhere, e.g., from BSON without writing & parsing JSON text. Its values may be of any type QVariant holds.
+         * Such a tree is for display only: values with no JSON form (e.g., ObjectID, Binary, Decimal128 & dates of BSON) aren't written by ToBinary(), which returns an empty image, and the tree has no text for setData() to edit.
+         * @param Value Gives the value (in column 1) & the children of the unique top-level node, which are moved into this model. Its key is ignored.
+         */
+        void FromTree(Node* const Value);
+        bool SetValueFromTree(const QModelIndex& Index, Node* const Value); // SetValueFromJSON() with a tree built elsewhere; the value & the children of Value are moved into this model
+
+        /**
+         * Map each node to its range in Text, so that the edits of Text & this model can be synced incrementally. JSON Lines isn't supported.
+         * @param Text The text this model was built from (or an equivalent one, e.g., the cached file), as shown in the editor.
+         * @return Whether Text matches this model. If not, edits aren't synced.
+         */
+        bool IndexTextSpans(const QStringView Text);
+
+        /**
+         * Patch the children touched by an edit of the indexed text in the smallest container enclosing it, rather than rebuilding the whole tree. Spaces typed between the children only move the spans.
+         * @param Position The position of the edit, as QTextDocument::contentsChange() reports it.
+         * @param Removed The number of characters removed at Position.
+         * @param Added The number of characters added at Position.
+         * @param Text Gives the edited text in [Start, Start + Length); Length < 0 means up to the end.
+         * @return Whether the tree matches the text again. If not (e.g., in the middle of typing), the same children are patched after the following edits.
+         */
+        bool SyncTextEdit(const qsizetype Position, const qsizetype Removed, const qsizetype Added, const std::function<QString(qsizetype Start, qsizetype Length)>& Text);
+        void ResetTextSpans(); // stop syncing edits until IndexTextSpans() is called again, e.g., after the text is replaced
+    signals:
+        void TextEdited(qsizetype Position, qsizetype Length, const QString& Text); // setData() has changed a value or a key; [Position, Position + Length) of the indexed text should be replaced with Text
     private:
+        template<class ValueT> void ResetToJSON(const ValueT& JSONDocument);
+        template<class DocumentT, class ViewT> void ResetToJSONLines(const ViewT Lines);
+        template<class DocumentT, class ViewT> void AppendToJSONLines(const ViewT Lines);
+
+        inline static constexpr char LazyRecordTag = 0; // the address is the internal pointer of the indices of the records of LazyLinesRoot, which are identified by their rows
+
         Node* GetItem(const QModelIndex& Index) const;
+        Node* GetRecord(const lsize_t Row) const; // the record of LazyLinesRoot, parsed on the 1st access
+        void ClearLazyRecords(); // called before the tree is reset
+        QModelIndex IndexOf(Node* const n) const;
+        qsizetype SpanStart(Node* n) const; // in the indexed text
+        void ShiftSpans(Node* const n, const qsizetype Delta); // n got Delta more characters: its ancestors grow and the following nodes move
+        bool Reparse(Node* const n, const qsizetype Start, const qsizetype Length, const std::function<QString(qsizetype, qsizetype)>& Text); // rebuild the subtree of n from its text
+        bool ReparseChildren(Node* const n, const qsizetype Start, const qsizetype Position, const qsizetype End, const qsizetype Delta, const std::function<QString(qsizetype, qsizetype)>& Text); // rebuild the children of n (starting at Start) touched by the edit of [Position, End), and only them
+        void MarkDirty(Node* n, lsize_t First, lsize_t Past); // the children of n in [First, Past) don't parse
         Node* RootNode = nullptr;
+        Node* LazyLinesRoot = nullptr; // the top-level node whose children are parsed on demand from LinesIndex
+        std::shared_ptr<const JSONLinesIndex> LinesIndex;
+        qsizetype ParseErrorOffset = -1;
+        bool SpansIndexed = false;
+        Node* DirtyNode = nullptr; // the container whose children in [DirtyFirst, DirtyFirst + DirtyCount) don't parse since they were edited; their spans are stale
+        lsize_t DirtyFirst = 0; // < 0: the whole value of DirtyNode (the root) doesn't parse
+        lsize_t DirtyCount = 0;
     };
 }
 
@@ -0,0 +1,104 @@
+#include "StartupProfiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+#include <QDebug>
+
+#include "rapidjson/writer.h"
+
+#include "FileSystemAccessor.h"
+
+namespace WritingMaterialsManager {
+    namespace {
+        const auto Epoch = std::chrono::steady_clock::now(); // initialized before main()
+    }
+
+    StartupProfiler::Phase::Phase(const char* const Name) : Name(Name), Start(IsEnabled() ? Now() : -1) {}
+    StartupProfiler::Phase::~Phase() {
+        if (Start >= 0) { Record(Name, Start, Now()); }
+    }
+
+    bool StartupProfiler::IsEnabled() {
+        static const bool Enabled = qEnvironmentVariableIsSet("WMM_STARTUP_PROFILE") || qEnvironmentVariableIsSet("WMM_STARTUP_TRACE");
+        return Enabled;
+    }
+
+    qint64 StartupProfiler::Now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Epoch).count(); }
+
+    void StartupProfiler::Record(const char* const Name, const qint64 Start, const qint64 End) {
+        const int Thread = CurrentThread();
+        std::lock_guard Lock(Mutex);
+        Events.push_back({ Name, Start, End, Thread });
+    }
+
+    void StartupProfiler::Mark(const char* const Name) {
+        if (IsEnabled()) { Record(Name, Now(), -1); }
+    }
+
+    void StartupProfiler::PrintSummary() {
+        if (qEnvironmentVariableIsSet("WMM_STARTUP_PROFILE") == false) { return; }
+        std::vector<Event> Sorted;
+        {
+            std::lock_guard Lock(Mutex);
+            Sorted = Events;
+        }
+        std::stable_sort(Sorted.begin(), Sorted.end(), [](const Event& A, const Event& B) { return A.Start < B.Start; });
+        qInfo().noquote() << "Startup phases (start, duration, thread, name):";
+        for (const auto& e: Sorted) {
+            const QByteArray Duration = e.End < 0 ? QByteArray("-").rightJustified(9) : QByteArray::number((e.End - e.Start) / 1e6, 'f', 1).rightJustified(9);
+            qInfo().noquote() << QString::asprintf("%9.1f ms %s ms  #%d  %s", e.Start / 1e6, Duration.constData(), e.Thread, e.Name);
+        }
+    }
+
+    void StartupProfiler::WriteTrace() {
+        if (qEnvironmentVariableIsSet("WMM_STARTUP_TRACE") == false) { return; }
+        try { WriteTrace(qEnvironmentVariable("WMM_STARTUP_TRACE")); }
+        catch (const std::runtime_error& e) {
+            qDebug() << "Exception at " << __FUNCTION__ << ": Failed to write the startup trace.";
+            qDebug() << e.what();
+        }
+    }
+
+    void StartupProfiler::WriteTrace(const QString& PathName) {
+        std::vector<Event> Copy;
+        {
+            std::lock_guard Lock(Mutex);
+            Copy = Events;
+        }
+        BufferedFileWriter Writer(PathName, 64 << 10);
+        rapidjson::Writer<BufferedFileWriter> w(Writer);
+        w.StartObject();
+        w.Key("displayTimeUnit"); w.String("ms");
+        w.Key("traceEvents");
+        w.StartArray();
+        for (const auto& e: Copy) { // the timestamps of the trace event format are in μs
+            w.StartObject();
+            w.Key("name"); w.String(e.Name);
+            w.Key("cat"); w.String("startup");
+            w.Key("ph"); w.String(e.End < 0 ? "i" : "X");
+            w.Key("ts"); w.Double(e.Start / 1e3);
+            if (e.End < 0) { w.Key("s"); w.String("g"); } // an instant event is drawn across all the threads
+            else { w.Key("dur"); w.Double((e.End - e.Start) / 1e3); }
+            w.Key("pid"); w.Int(1);
+            w.Key("tid"); w.Int(e.Thread);
+            w.EndObject();
+        }
+        w.EndArray();
+        w.EndObject();
+        Writer.Commit();
+    }
+
+    void StartupProfiler::Clear() {
+        std::lock_guard Lock(Mutex);
+        Events.clear();
+    }
+
+    int StartupProfiler::CurrentThread() {
+        static std::atomic<int> ThreadCount = 0;
+        thread_local const int Thread = ThreadCount++;
+        return Thread;
+    }
+}
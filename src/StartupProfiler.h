@@ -0,0 +1,52 @@
+#ifndef WRITING_MATERIALS_MANAGER_STARTUPPROFILER_H
+#define WRITING_MATERIALS_MANAGER_STARTUPPROFILER_H
+
+#include <mutex>
+#include <vector>
+
+#include <QString>
+
+namespace WritingMaterialsManager {
+    /**
+     * Record the named phases of startup with monotonic timestamps (in ns since the process started), from any thread.
+     * Nothing is recorded unless one of these environment variables is set:
+     * WMM_STARTUP_PROFILE: print a summary of the phases by PrintSummary().
+     * WMM_STARTUP_TRACE: the pathname of a Chrome trace JSON file (for chrome://tracing or Perfetto) written by WriteTrace().
+     */
+    class StartupProfiler {
+    public:
+        class Phase { // a phase lasts from the construction to the destruction of this
+        public:
+            explicit Phase(const char* const Name); // Name must be alive until the trace is written, e.g., a string literal
+            ~Phase();
+            Phase(const Phase&) = delete;
+            Phase& operator=(const Phase&) = delete;
+        private:
+            const char* const Name;
+            const qint64 Start; // -1 if disabled
+        };
+
+        static bool IsEnabled();
+        static qint64 Now(); // ns since the process started
+        static void Record(const char* const Name, const qint64 Start, const qint64 End); // recorded even if disabled. An instant event if End < 0.
+        static void Mark(const char* const Name); // record an instant event, e.g., the 1st idle of the event loop
+        static void PrintSummary(); // if WMM_STARTUP_PROFILE is set
+        static void WriteTrace(); // if WMM_STARTUP_TRACE is set; failures are only reported by qDebug
+        static void WriteTrace(const QString& PathName); // throws std::runtime_error on failure
+        static void Clear();
+    private:
+        struct Event {
+            const char* Name;
+            qint64 Start;
+            qint64 End; // < 0 for an instant event
+            int Thread; // numbered in the order of the 1st event of each thread
+        };
+
+        inline static std::mutex Mutex;
+        inline static std::vector<Event> Events;
+
+        static int CurrentThread();
+    };
+}
+
+#endif // WRITING_MATERIALS_MANAGER_STARTUPPROFILER_H
@@ -7,6 +7,7 @@ namespace WritingMaterialsManager {
     class TextFormatter {
     public:
         virtual void Format(QString& Text) = 0;
+        virtual QString Format(const QByteArrayView UTF8Text) = 0; // format UTF-8 text read where it is (e.g., a mapped file) into a new QString, without converting the input into a QString first
     };
 }
 
@@ -0,0 +1,123 @@
+#include "Transcoder.h"
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include <QSet>
+#include <QStringDecoder>
+#include <QSysInfo>
+#include <QTextCodec>
+
+namespace WritingMaterialsManager {
+    namespace {
+        using Rule = Transcoder::BoundaryRule;
+        using ChunkDecoder = std::function<QString(QByteArrayView Chunk, bool First)>;
+
+        const QSet<int> ASCIIResyncMIBs = { // GB18030, GBK, GB2312, Big5, Big5-HKSCS, Shift_JIS, EUC-JP, EUC-KR, Windows-31J
+            114, 113, 2025, 2026, 2101, 17, 18, 38, 2024,
+        };
+
+        Rule RuleOf(QTextCodec* const Codec) {
+            const QByteArray Name = Codec->name().toUpper();
+            if (Name.startsWith("ISO-2022") || Name.startsWith("UTF-7") || Name.startsWith("HZ")) { return Rule::None; } // stateful
+            if (ASCIIResyncMIBs.contains(Codec->mibEnum())) { return Rule::ASCIIResync; }
+            char Bytes[256];
+            for (int i = 0; i < 256; ++i) { Bytes[i] = static_cast<char>(i); }
+            QTextCodec::ConverterState State(QTextCodec::IgnoreHeader);
+            const QString Decoded = Codec->toUnicode(Bytes, sizeof(Bytes), &State);
+            return Decoded.size() == 256 && State.remainingChars == 0 ? Rule::Any : Rule::None; // every byte is a character
+        }
+    }
+
+    QString Transcoder::Decode(const QByteArrayView Data, const QByteArray& Charset, const int ThreadCount, const qsizetype MinChunkSize) {
+        QByteArrayView Body = Data; // without the BOM
+        Rule BoundaryRule = Rule::None;
+        ChunkDecoder DecodeChunk;
+        if (auto Encoding = QStringConverter::encodingForName(Charset); Encoding.has_value()) {
+            using E = QStringConverter::Encoding;
+            constexpr bool LittleEndian = QSysInfo::ByteOrder == QSysInfo::LittleEndian;
+            // Resolve the byte order by the BOM so that every chunk can be decoded on its own. Without a BOM, QStringDecoder assumes the host byte order.
+            if (*Encoding == E::Utf16) { Encoding = Data.startsWith("\xFF\xFE") ? E::Utf16LE : Data.startsWith("\xFE\xFF") ? E::Utf16BE : LittleEndian ? E::Utf16LE : E::Utf16BE; }
+            else if (*Encoding == E::Utf32) {
+                Encoding = Data.startsWith(QByteArrayView("\xFF\xFE\x00\x00", 4)) ? E::Utf32LE : Data.startsWith(QByteArrayView("\x00\x00\xFE\xFF", 4)) ? E::Utf32BE : LittleEndian ? E::Utf32LE : E::Utf32BE;
+            }
+            QByteArrayView BOM;
+            switch (*Encoding) {
+            case E::Utf8: BOM = "\xEF\xBB\xBF"; BoundaryRule = Rule::UTF8; break;
+            case E::Utf16LE: BOM = "\xFF\xFE"; BoundaryRule = Rule::UTF16LE; break;
+            case E::Utf16BE: BOM = "\xFE\xFF"; BoundaryRule = Rule::UTF16BE; break;
+            case E::Utf32LE: BOM = QByteArrayView("\xFF\xFE\x00\x00", 4); BoundaryRule = Rule::UTF32; break;
+            case E::Utf32BE: BOM = QByteArrayView("\x00\x00\xFE\xFF", 4); BoundaryRule = Rule::UTF32; break;
+            case E::Latin1: BoundaryRule = Rule::Any; break;
+            default: break; // the system charset may be stateful
+            }
+            if (BOM.isEmpty() == false && Body.startsWith(BOM)) { Body = Body.sliced(BOM.size()); }
+            DecodeChunk = [Encoding = *Encoding](const QByteArrayView Chunk, bool) -> QString {
+                QStringDecoder Decoder(Encoding, QStringConverter::Flag::ConvertInitialBom); // the BOM has been skipped, thus U+FEFF at the beginning of a chunk is a character
+                return Decoder.decode(Chunk);
+            };
+        }
+        else {
+            QTextCodec* const Codec = QTextCodec::codecForName(Charset);
+            if (Codec == nullptr) { throw std::runtime_error(("Charset " + Charset + " is not supported.").constData()); }
+            BoundaryRule = RuleOf(Codec);
+            DecodeChunk = [Codec](const QByteArrayView Chunk, const bool First) -> QString {
+                QTextCodec::ConverterState State(First ? QTextCodec::DefaultConversion : QTextCodec::IgnoreHeader); // the states are independent, so is the conversion
+                return Codec->toUnicode(Chunk.data(), Chunk.size(), &State);
+            };
+        }
+
+        const qsizetype ChunkCount = BoundaryRule == Rule::None ? 1 : std::clamp<qsizetype>(Body.size() / std::max<qsizetype>(MinChunkSize, 1), 1, std::max(ThreadCount, 1));
+        const QList<qsizetype> Offsets = Split(Body, BoundaryRule, ChunkCount);
+        if (Offsets.size() <= 2) { return DecodeChunk(Body, true); }
+        std::vector<std::future<QString>> Tasks;
+        for (qsizetype i = 1; i + 1 < Offsets.size(); ++i) {
+            Tasks.emplace_back(std::async(std::launch::async, DecodeChunk, Body.sliced(Offsets[i], Offsets[i + 1] - Offsets[i]), false));
+        }
+        std::vector<QString> Parts;
+        Parts.emplace_back(DecodeChunk(Body.first(Offsets[1]), true)); // the 1st chunk is decoded by this thread
+        qsizetype Length = Parts.back().size();
+        for (auto& Task: Tasks) {
+            Parts.emplace_back(Task.get());
+            Length += Parts.back().size();
+        }
+        QString Text;
+        Text.reserve(Length);
+        for (const auto& Part: Parts) { Text.append(Part); }
+        return Text;
+    }
+
+    QList<qsizetype> Transcoder::Split(const QByteArrayView Data, const BoundaryRule Rule, const qsizetype ChunkCount) {
+        QList<qsizetype> Offsets = { 0 };
+        for (qsizetype k = 1; k < ChunkCount; ++k) {
+            const qsizetype Ideal = Data.size() / ChunkCount * k;
+            const qsizetype Limit = std::min(Data.size(), Ideal + MaxResyncDistance);
+            for (qsizetype i = std::max(Ideal, Offsets.back() + 1); i < Limit; ++i) {
+                if (IsBoundary(Data, i, Rule)) {
+                    Offsets.emplace_back(i);
+                    break;
+                }
+            } // no boundary nearby: this chunk is merged into the next one
+        }
+        Offsets.emplace_back(Data.size());
+        return Offsets;
+    }
+
+    bool Transcoder::IsBoundary(const QByteArrayView Data, const qsizetype Offset, const BoundaryRule Rule) noexcept {
+        if (Offset <= 0 || Offset >= Data.size()) { return true; }
+        const auto Byte = [&Data](const qsizetype i) { return static_cast<unsigned char>(Data[i]); };
+        switch (Rule) {
+        case BoundaryRule::None: return false;
+        case BoundaryRule::Any: return true;
+        case BoundaryRule::ASCIIResync: return Byte(Offset - 1) < 0x30;
+        case BoundaryRule::UTF8: return (Byte(Offset) & 0xC0) != 0x80;
+        case BoundaryRule::UTF16LE: return Offset % 2 == 0 && (Byte(Offset - 1) & 0xFC) != 0xD8;
+        case BoundaryRule::UTF16BE: return Offset % 2 == 0 && (Byte(Offset - 2) & 0xFC) != 0xD8;
+        case BoundaryRule::UTF32: return Offset % 4 == 0;
+        }
+        return false;
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef WRITING_MATERIALS_MANAGER_TRANSCODER_H
+#define WRITING_MATERIALS_MANAGER_TRANSCODER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QThread>
+
+namespace WritingMaterialsManager {
+    class Transcoder { // decode large text in parallel: the input is split at safe character boundaries, the chunks are decoded independently, then the results are concatenated
+    public:
+        static constexpr qsizetype DefaultMinChunkSize = 4 << 20; // smaller chunks don't pay for the threads
+        static constexpr qsizetype MaxResyncDistance = 64 << 10; // how far a boundary is searched for beyond the ideal position
+
+        enum class BoundaryRule { // where a chunk may end
+            None,           // stateful charsets, e.g., ISO-2022-JP, which are decoded in 1 chunk
+            Any,            // single-byte charsets
+            ASCIIResync,    // ASCII-compatible multibyte charsets (GB18030, Big5, Shift_JIS, EUC-*, etc.), after a byte < 0x30, which is never a trailing byte
+            UTF8,           // before a byte which isn't a continuation byte
+            UTF16LE,        // at an even offset which doesn't follow a high surrogate
+            UTF16BE,
+            UTF32,          // at a multiple of 4
+        };
+
+        /**
+         * @param Charset a name accepted by QStringConverter::encodingForName() or QTextCodec::codecForName()
+         * @param ThreadCount max number of chunks decoded at the same time
+         * @return the decoded text, the same as decoding by a single QStringDecoder or QTextDecoder. The BOM (if any) is skipped.
+         */
+        static QString Decode(const QByteArrayView Data, const QByteArray& Charset, const int ThreadCount = QThread::idealThreadCount(), const qsizetype MinChunkSize = DefaultMinChunkSize);
+        static QList<qsizetype> Split(const QByteArrayView Data, const BoundaryRule Rule, const qsizetype ChunkCount); // the offsets where the chunks begin, followed by Data.size()
+        static bool IsBoundary(const QByteArrayView Data, const qsizetype Offset, const BoundaryRule Rule) noexcept; // whether a chunk may begin at Offset
+    };
+}
+
+#endif //WRITING_MATERIALS_MANAGER_TRANSCODER_H
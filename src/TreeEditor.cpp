@@ -1,27 +1,127 @@
 #include "TreeEditor.h"
 
+#include <algorithm>
+#include <climits>
 #include <mutex>
 #include <stdexcept>
+#include <vector>
 
 #include <QApplication>
+#include <QDebug>
 #include <QFileDialog>
 #include <QGridLayout>
+#include <QInputDialog>
+#include <QMessageBox>
+#include <QTextBlock>
+#include <QTextCursor>
 #include <QTextCodec>
+#include <QThreadPool>
+#include <QTimer>
 
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/reader.h"
+
+#include "CharsetDetector.h"
+#include "DocumentCache.h"
 #include "JSONFormatter.h"
 #include "JSONHighlighter.h"
+#include "JSONLinesIndex.h"
 #include "TextArea.h"
+#include "Transcoder.h"
+#include "UTFConverter.h"
 
 #include "FileSystemAccessor.h"
 
 namespace WritingMaterialsManager {
-    const std::unordered_map<QByteArray, TreeEditor::SupportedFileType, CaseInsensitiveHasher, CaseInsensitiveStringComparator> TreeEditor::FileTypeToEnumID = {
-        { "JSON",                  SupportedFileType::JSON },
-        { "MongoDB Extended JSON", SupportedFileType::MongoDBExtendedJSON },
-    }; // mainly for switch-case statement so far.
+    namespace {
+        constexpr const char* CommonCharsets[] = { // shown before the full list, which has hundreds of entries
+            "UTF-8", "UTF-16LE", "UTF-16BE", "GB18030", "GBK", "Big5", "Shift_JIS", "EUC-JP", "EUC-KR", "ISO-8859-1", "windows-1252",
+        };
+
+        QAction* AddCharsetAction(QMenu* const Menu, const QByteArray& Charset) {
+            QAction* const Action = Menu->addAction(QString::fromLatin1(Charset));
+            Action->setData(Charset); // the text may be decorated with an accelerator by the style
+            return Action;
+        }
+
+        class DocumentStream { // RapidJSON input stream over the blocks of a QTextDocument, so the document isn't copied into 1 string
+        public:
+            using Ch = char16_t;
+
+            explicit DocumentStream(const QTextDocument* const Document) : Block(Document->begin()) { Load(); }
+
+            Ch Peek() const { return Position < Text.size() ? Text[Position].unicode() : u'\0'; }
+            Ch Take() {
+                if (Position >= Text.size()) { return u'\0'; }
+                const Ch c = Text[Position++].unicode();
+                if (Position == Text.size()) { Next(); }
+                return c;
+            }
+            size_t Tell() const { return Consumed + Position; }
+
+            // in-situ parsing is not supported
+            Ch* PutBegin() { Q_ASSERT(false); return nullptr; }
+            void Put(Ch) { Q_ASSERT(false); }
+            void Flush() { Q_ASSERT(false); }
+            size_t PutEnd(Ch*) { Q_ASSERT(false); return 0; }
+        private:
+            QTextBlock Block;
+            QString Text; // the current block with its line break
+            qsizetype Position = 0;
+            size_t Consumed = 0; // characters of the blocks before the current one
+
+            void Load() {
+                Text = Block.isValid() ? Block.text() : QString();
+                if (Block.isValid() && Block.next().isValid()) { Text += u'\n'; }
+                Position = 0;
+            }
+            void Next() {
+                Consumed += Text.size();
+                Block = Block.next();
+                Load();
+            }
+        };
+
+        class EncodingStream { // RapidJSON output stream of UTF-16, which is encoded into the charset of the file chunk by chunk
+        public:
+            using Ch = char16_t;
+
+            EncodingStream(BufferedFileWriter& Writer, const QByteArray& Charset) : Writer(Writer) {
+                if (Charset == "UTF-8") { return; } // UTFConverter is faster
+                QTextCodec* const Codec = QTextCodec::codecForName(Charset);
+                if (Codec == nullptr) { throw std::runtime_error(("Unknown charset " + Charset + '.').constData()); }
+                Encoder.reset(Codec->makeEncoder()); // stateful across the chunks
+            }
+
+            void Put(const Ch c) {
+                Chunk.push_back(c);
+                if (static_cast<qsizetype>(Chunk.size()) >= ChunkSize) { Encode(false); }
+            }
+            void Write(const QStringView Text) {
+                Chunk.append(reinterpret_cast<const char16_t*>(Text.utf16()), Text.size());
+                if (static_cast<qsizetype>(Chunk.size()) >= ChunkSize) { Encode(false); }
+            }
+            void Flush() {} // RapidJSON flushes at the end of each value
+            void Finish() { Encode(true); }
+        private:
+            static constexpr qsizetype ChunkSize = 1 << 20;
+
+            BufferedFileWriter& Writer;
+            std::unique_ptr<QTextEncoder> Encoder;
+            std::u16string Chunk;
+
+            void Encode(const bool Last) {
+                qsizetype n = Chunk.size();
+                if (Last == false && n > 0 && QChar::isHighSurrogate(Chunk[n - 1])) { --n; } // keep a surrogate pair in 1 chunk
+                const QStringView Part(Chunk.data(), n);
+                Writer.Write(Encoder != nullptr ? Encoder->fromUnicode(Part) : UTFConverter::ToUTF8(Part));
+                Chunk.erase(0, n);
+            }
+        };
+    }
 
     TreeEditor::TreeEditor(const QByteArray& FileType, const std::shared_ptr<QtTreeModel>& TreeModel, QWidget* const parent) :
-        QWidget(parent), TabView(new QTabWidget), IntuitiveView(new TreeView), RawView(new TextArea), TreeModel(TreeModel) {
+        QWidget(parent), TabView(new QTabWidget), IntuitiveView(new TreeView), RawView(new TextArea), LargeRawView(new LargeTextView(this)), LargeRawViewSyncTimer(new QTimer(this)), TreeModel(TreeModel) {
         static std::once_flag StaticInitCompleted;
         std::call_once(StaticInitCompleted, [](){
             // menu item Open
@@ -29,14 +129,29 @@ namespace WritingMaterialsManager {
             MenuAction::Open->setShortcut(QKeySequence::Open);
             MenuAction::Open->setStatusTip(tr("打开一个文件"));
 
-            // menu item Charset
-            Menu::Charset = new QMenu(tr("字符集"));
-            auto AvailableCharsets = QTextCodec::availableCodecs();
-            std::sort(AvailableCharsets.begin(), AvailableCharsets.end(), [](const QByteArray& A, const QByteArray& B) { return A < B; });
-            for (const auto& Charset: AvailableCharsets) {
-                MenuAction::SetCharset.emplace_back(new QAction(Charset));
-                Menu::Charset->addAction(MenuAction::SetCharset.back());
-            }
+            // menu item Save, SaveAs & FormatOnSave
+            MenuAction::Save = new QAction(tr("保存"));
+            MenuAction::Save->setShortcut(QKeySequence::Save);
+            MenuAction::Save->setStatusTip(tr("保存当前文件"));
+            MenuAction::SaveAs = new QAction(tr("另存为"));
+            MenuAction::SaveAs->setShortcut(QKeySequence::SaveAs);
+            MenuAction::SaveAs->setStatusTip(tr("将当前内容保存为另一个文件"));
+            MenuAction::FormatOnSave = new QAction(tr("保存时格式化"));
+            MenuAction::FormatOnSave->setCheckable(true);
+            MenuAction::FormatOnSave->setStatusTip(tr("保存 JSON 时将其格式化"));
+
+            // menu item Follow
+            MenuAction::Follow = new QAction(tr("跟踪文件"));
+            MenuAction::Follow->setCheckable(true);
+            MenuAction::Follow->setStatusTip(tr("文件增长时自动读取新增的内容"));
+
+            // menu item GoToRecord
+            MenuAction::GoToRecord = new QAction(tr("转到记录"));
+            MenuAction::GoToRecord->setStatusTip(tr("转到 JSON Lines 文件的指定记录"));
+
+            // menu item GoToLine
+            MenuAction::GoToLine = new QAction(tr("转到行"));
+            MenuAction::GoToLine->setStatusTip(tr("转到原始内容的指定行"));
         });
 
         // show proper information on the status bar when the corresponding GUI component is focused
@@ -46,25 +161,51 @@ namespace WritingMaterialsManager {
         connect(RawView, &TextArea::MouseDown, this, &TreeEditor::ShouldUpdatePathName);
         connect(RawView, &TextArea::MouseDown, this, &TreeEditor::ShouldUpdateFileType);
         connect(RawView, &TextArea::MouseDown, this, &TreeEditor::ShouldUpdateCharset);
+        connect(LargeRawView, &LargeTextView::MouseDown, this, &TreeEditor::ShouldUpdatePathName);
+        connect(LargeRawView, &LargeTextView::MouseDown, this, &TreeEditor::ShouldUpdateFileType);
+        connect(LargeRawView, &LargeTextView::MouseDown, this, &TreeEditor::ShouldUpdateCharset);
+
+        // sync the edits of either view to the other
+        connect(RawView->document(), &QTextDocument::contentsChange, this, &TreeEditor::SyncRawViewEdit);
+        connect(TreeModel.get(), &QtTreeModel::TextEdited, this, &TreeEditor::SyncTreeEdit);
+        LargeRawViewSyncTimer->setSingleShot(true);
+        LargeRawViewSyncTimer->setInterval(500);
+        connect(LargeRawView, &LargeTextView::TextChanged, this, [this]() { // the large text is parsed again once the typing pauses
+            ++LargeRawViewRevision;
+            LargeRawViewSyncTimer->start();
+        });
+        SyncPool.setMaxThreadCount(1);
+        connect(LargeRawViewSyncTimer, &QTimer::timeout, this, &TreeEditor::SyncLargeRawViewEdit);
 
         setFocusPolicy(Qt::StrongFocus); // the widget accepts focus by both tabbing and clicking. On macOS this will also be indicate that the widget accepts tab focus when in 'Text/List focus mode'.
         SetFileType(FileType);
-        SetCharset("UTF-8"); // default charset: UTF-8
+        SetCharset(AutoCharset); // default charset: detected for each file
 
         IntuitiveView->setModel(TreeModel.get());
+        IntuitiveView->setUniformRowHeights(true); // the rows needn't be measured one by one, which matters for millions of records
         TabView->addTab(IntuitiveView, tr("直观"));
         TabView->addTab(RawView, tr("原始"));
+        LargeRawView->hide(); // swapped with RawView when huge text is open
 
         setLayout(new QGridLayout);
         layout()->setContentsMargins(0, 0, 0, 0);
         layout()->addWidget(TabView);
     }
 
-    TreeEditor::~TreeEditor() {}
+    TreeEditor::~TreeEditor() { SyncPool.waitForDone(); } // the trees posted to this are discarded with it
 
-    QString TreeEditor::GetText() { return RawView->toPlainText(); }
-    void TreeEditor::SetText(const QString& Text) { RawView->setPlainText(Text); }
-    void TreeEditor::AppendText(const QString& Text) { RawView->appendPlainText(Text); }
+    QString TreeEditor::GetText() { return IsLargeRawViewShown() ? UTFConverter::ToUTF16(LargeRawView->GetTable().Text()) : RawView->toPlainText(); }
+    void TreeEditor::SetText(const QString& Text) {
+        ShowLargeRawView(false);
+        Syncing = true; // the tree is rebuilt from the new text, rather than patched
+        RawView->setPlainText(Text);
+        Syncing = false;
+        TreeModel->ResetTextSpans();
+    }
+    void TreeEditor::AppendText(const QString& Text) {
+        if (IsLargeRawViewShown()) { LargeRawView->AppendText(UTFConverter::ToUTF8(u'\n' + Text)); } // as appendPlainText()
+        else { RawView->appendPlainText(Text); }
+    }
 
     QByteArray TreeEditor::GetPathName() const { return PathName; }
     void TreeEditor::SetPathName(const QByteArray& FileName) {
@@ -77,42 +218,63 @@ namespace WritingMaterialsManager {
         using namespace std;
         using enum SupportedFileType;
 
-        const auto I = FileTypeToEnumID.find(FileType);
-        if (I == FileTypeToEnumID.cend()) { // not supported file type
+        const auto* const I = FileTypeToEnumID.Find(FileType);
+        if (I == nullptr) { // not supported file type
             this->FileType = "/* File Type Not Supported */";
             return;
         }
-        switch (I->second) { // supported file type, set the corresponding formatter and highlighter
-        case JSON: case MongoDBExtendedJSON:
+        switch (I->Value) { // supported file type, set the corresponding formatter and highlighter
+        case JSON: case MongoDBExtendedJSON: case JSONLines:
             Formatter = make_shared<JSONFormatter>();
             Highlighter = make_shared<JSONHighlighter>(RawView->document());
-            this->FileType = I->first;
+            this->FileType = QByteArray(I->Key.data(), I->Key.size());
             break;
         }
         emit ShouldUpdateFileType();
     }
 
-    QByteArray TreeEditor::GetCharset() const { return Charset; }
-    void TreeEditor::SetCharset() {
-        this->Charset = static_cast<QAction*>(sender())->text().toUtf8();
-        emit ShouldUpdateCharset();
+    QByteArray TreeEditor::GetCharset() const { return Charset == AutoCharset && DetectedCharset.isEmpty() == false ? DetectedCharset : Charset; }
+    void TreeEditor::SetCharset(QAction* const Action) {
+        if (Action->data().isValid()) { SetCharset(Action->data().toByteArray()); }
     }
     void TreeEditor::SetCharset(const QByteArray& Charset) {
         this->Charset = Charset;
+        DetectedCharset.clear();
         emit ShouldUpdateCharset();
     }
 
+    bool TreeEditor::IsFollowing() const { return Following; }
+    void TreeEditor::SetFollowing(const bool Enabled) {
+        if (Following == Enabled) { return; }
+        Following = Enabled;
+        if (Following == false) {
+            if (FileWatcher->files().isEmpty() == false) { FileWatcher->removePaths(FileWatcher->files()); }
+            return;
+        }
+        if (FileWatcher == nullptr) {
+            FileWatcher = new QFileSystemWatcher(this);
+            connect(FileWatcher, &QFileSystemWatcher::fileChanged, this, &TreeEditor::FollowFile);
+        }
+        if (PathName.isEmpty() == false) { OpenFile(QString::fromUtf8(PathName)); } // reload so that the offset is at a line boundary, and start watching
+    }
+
     void TreeEditor::ArrangeContentView() {
+        if (IsLargeRawViewShown()) { return; } // huge text is neither formatted nor highlighted
         auto PlainText = RawView->toPlainText();
         auto PlainTextCopy = PlainText;
 
         Highlighter->setDocument(nullptr); // suspend the highlighting before the consummation of formatting
         try { // attempt to format the text
             Formatter->Format(PlainText);
+            Syncing = true; // the values are unchanged, but the spans are
             RawView->setPlainText(PlainText);
+            Syncing = false;
+            IndexRawView();
         }
         catch (const std::runtime_error& e) { // format failed
-            RawView->setPlainText(PlainTextCopy); // restore the original text
+            Syncing = true;
+            RawView->setPlainText(PlainTextCopy); // restore the original text, whose spans are unchanged
+            Syncing = false;
         }
         Highlighter->setDocument(RawView->document());
 //        Highlighter->Highlight(Highlighter->document()->toPlainText());
@@ -125,21 +287,41 @@ namespace WritingMaterialsManager {
         // construct the context menu
         ContextMenu->addAction(MenuAction::Open);
         const auto OpenFileConnection = connect(MenuAction::Open, &QAction::triggered, this, qOverload<>(&TreeEditor::OpenFile));
-        QList<QMetaObject::Connection> CharsetEventHandlerConnections;
-        for (auto* const SetCharsetAction: MenuAction::SetCharset) { // connect signals and slots for charset selection & record the connection for disposal
-            CharsetEventHandlerConnections.emplace_back(connect(SetCharsetAction, &QAction::triggered, this, qOverload<>(&TreeEditor::SetCharset)));
-        }
+        ContextMenu->addAction(MenuAction::Save);
+        const auto SaveFileConnection = connect(MenuAction::Save, &QAction::triggered, this, qOverload<>(&TreeEditor::SaveFile));
+        ContextMenu->addAction(MenuAction::SaveAs);
+        const auto SaveFileAsConnection = connect(MenuAction::SaveAs, &QAction::triggered, this, &TreeEditor::SaveFileAs);
+        MenuAction::FormatOnSave->setChecked(FormattingOnSave); // the action is shared by all the tree editors
+        ContextMenu->addAction(MenuAction::FormatOnSave);
+        const auto FormatOnSaveConnection = connect(MenuAction::FormatOnSave, &QAction::toggled, this, &TreeEditor::SetFormattingOnSave);
+        MenuAction::Follow->setChecked(Following); // the action is shared by all the tree editors
+        ContextMenu->addAction(MenuAction::Follow);
+        const auto FollowConnection = connect(MenuAction::Follow, &QAction::toggled, this, &TreeEditor::SetFollowing);
+        MenuAction::GoToRecord->setEnabled(IsJSONLines());
+        ContextMenu->addAction(MenuAction::GoToRecord);
+        const auto GoToRecordConnection = connect(MenuAction::GoToRecord, &QAction::triggered, this, qOverload<>(&TreeEditor::GoToRecord));
+        ContextMenu->addAction(MenuAction::GoToLine);
+        const auto GoToLineConnection = connect(MenuAction::GoToLine, &QAction::triggered, this, qOverload<>(&TreeEditor::GoToLine));
+        static std::once_flag CharsetMenuBuilt;
+        std::call_once(CharsetMenuBuilt, &TreeEditor::BuildCharsetMenu);
+        const auto SetCharsetConnection = connect(Menu::Charset, &QMenu::triggered, this, qOverload<QAction*>(&TreeEditor::SetCharset)); // the actions of AllCharsets are triggered through Charset, too
         ContextMenu->addMenu(Menu::Charset); // add charset selection submenu with charset menu items
 
         ContextMenu->exec(Event->globalPos()); // popup context menu and wait for action
 
         // dispose the disappeared context menu
         disconnect(OpenFileConnection);
-        for (const auto& Connection : CharsetEventHandlerConnections) { disconnect(Connection); }
+        disconnect(SaveFileConnection);
+        disconnect(SaveFileAsConnection);
+        disconnect(FormatOnSaveConnection);
+        disconnect(FollowConnection);
+        disconnect(GoToRecordConnection);
+        disconnect(GoToLineConnection);
+        disconnect(SetCharsetConnection);
     }
 
     void TreeEditor::OpenFile() {
-        const QString FileName = QFileDialog::getOpenFileName(this, tr("打开文件"), QDir::currentPath(), tr("JSON (*.json)"));
+        const QString FileName = QFileDialog::getOpenFileName(this, tr("打开文件"), QDir::currentPath(), tr("JSON (*.json);;JSON Lines (*.jsonl *.ndjson)"));
         if (FileName.isEmpty() == false) { OpenFile(FileName); }
     }
 
@@ -148,30 +330,372 @@ namespace WritingMaterialsManager {
         std::shared_ptr<QFileInfo> FileInfo = FileSystemAccessor::GetFileInfo(File);
         SetPathName(PathName.toUtf8());
         SetFileType(FileInfo->suffix().toUtf8());
-        QByteArray FileContentsUTF8; // for parsing by JSON libraries
-        QString FileContentsUTF16; // for display
-        if (Charset == "<Charset>") { Charset = "UTF-8"; } // default encoding: UTF-8
-        if (Charset == "UTF-8") {
-            FileContentsUTF8 = FileSystemAccessor::GetAllRawContents(File);
-            FileContentsUTF16 = QString::fromUtf8(FileContentsUTF8);
-        }
-        else if (Charset == "UTF-16") {
-            QTextStream IFStream(File.get());
-            IFStream.setEncoding(QStringConverter::Utf16);
-            FileContentsUTF16 = IFStream.readAll();
-            FileContentsUTF8 = FileContentsUTF16.toUtf8();
+        // Each file is decoded exactly once. UTF-8 is parsed as is, and the other charsets are parsed in UTF-16, which is also used for display.
+        const QByteArray FileContentsRaw = FileSystemAccessor::GetAllMappedContents(File); // no copy, valid while File is open
+        if (Charset == AutoCharset) { // detect before decoding so that the proper decoder is used at the first attempt
+            DetectedCharset = CharsetDetector::Detect(FileContentsRaw);
+            emit ShouldUpdateCharset();
+        }
+        const QByteArray ReadingCharset = GetCharset();
+        UTF8BOM = ReadingCharset == "UTF-8" && FileContentsRaw.startsWith("\xEF\xBB\xBF");
+        FollowOffset = FileContentsRaw.size();
+        FollowedBirthTime = FileInfo->birthTime();
+        if (Following) { // watch the open file only
+            if (const QStringList Watched = FileWatcher->files(); Watched != QStringList{ PathName }) {
+                if (Watched.isEmpty() == false) { FileWatcher->removePaths(Watched); }
+                FileWatcher->addPath(PathName);
+            }
+        }
+        if (ReadingCharset == "UTF-8") {
+            QByteArrayView FileContentsUTF8 = QByteArrayView(FileContentsRaw).sliced(UTF8BOM ? 3 : 0); // the parser doesn't accept the BOM
+            if (Following && IsJSONLines()) { // an incomplete last line is left to the next read
+                const qsizetype CompleteSize = FileContentsUTF8.lastIndexOf('\n') + 1;
+                FollowOffset -= FileContentsUTF8.size() - CompleteSize;
+                FileContentsUTF8.truncate(CompleteSize);
+            }
+            const auto MappedContents = std::make_shared<std::pair<std::shared_ptr<QFile>, QByteArray>>(File, FileContentsRaw); // keep the file open & mapped for LargeRawView & the index
+            MappedFile = MappedContents;
+            SetRawViewText(FileContentsUTF8, MappedContents);
+            if (IsJSONLines()) { // indexed in 1 pass over the mapped file, and the records are parsed as they're shown
+                TreeModel->FromJSONLines(std::make_shared<const JSONLinesIndex>(FileContentsUTF8, MappedContents));
+            }
+            else if (DocumentCache::Load(PathName, FileContentsRaw, ReadingCharset, *TreeModel) == false) { // an unchanged large file isn't parsed again
+                TreeModel->FromJSON(FileContentsUTF8);
+                if (TreeModel->GetParseErrorOffset() < 0) { DocumentCache::Store(PathName, FileContentsRaw, ReadingCharset, *TreeModel); }
+                else { ShowParseError(FileContentsUTF8); }
+            }
+            IndexRawView();
+            ExpandTree();
+            return;
+        }
+        MappedFile.reset(); // decoded into memory
+        const QString FileContentsUTF16 = Transcoder::Decode(FileContentsRaw, ReadingCharset); // in parallel for large files
+        std::shared_ptr<const QByteArray> FileContentsUTF8; // for LargeRawView & the index of JSON Lines
+        if (FileContentsUTF16.size() > RawViewSizeLimit || IsJSONLines()) { FileContentsUTF8 = std::make_shared<const QByteArray>(UTFConverter::ToUTF8(FileContentsUTF16)); }
+        if (FileContentsUTF16.size() > RawViewSizeLimit) { SetRawViewText(*FileContentsUTF8, FileContentsUTF8); } // LargeRawView stores UTF-8
+        else { SetText(FileContentsUTF16); }
+        if (IsJSONLines()) { TreeModel->FromJSONLines(std::make_shared<const JSONLinesIndex>(*FileContentsUTF8, FileContentsUTF8)); } // encoded once, so that the records are indexed & parsed as they're shown, like those of UTF-8
+        else if (DocumentCache::Load(PathName, FileContentsRaw, ReadingCharset, *TreeModel) == false) {
+            TreeModel->FromJSON(QStringView(FileContentsUTF16));
+            if (TreeModel->GetParseErrorOffset() < 0) { DocumentCache::Store(PathName, FileContentsRaw, ReadingCharset, *TreeModel); }
+            else { ShowParseError(QStringView(FileContentsUTF16)); }
         }
+        IndexRawView();
+        ExpandTree();
+    }
+
+    void TreeEditor::SaveFile() {
+        if (PathName.isEmpty()) {
+            SaveFileAs();
+            return;
+        }
+        try { SaveFile(QString::fromUtf8(PathName)); }
+        catch (const std::runtime_error& e) { QMessageBox::warning(this, tr("保存失败"), QString::fromUtf8(e.what())); } // the file is untouched
+    }
+
+    void TreeEditor::SaveFileAs() {
+        const QString FileName = QFileDialog::getSaveFileName(this, tr("保存文件"), QDir::currentPath(), tr("JSON (*.json);;JSON Lines (*.jsonl *.ndjson)"));
+        if (FileName.isEmpty()) { return; }
+        try { SaveFile(FileName); }
+        catch (const std::runtime_error& e) { QMessageBox::warning(this, tr("保存失败"), QString::fromUtf8(e.what())); }
+    }
+
+    void TreeEditor::SaveFile(const QString& PathName) {
+        using namespace rapidjson;
+
+        const QByteArray SavingCharset = GetCharset() == AutoCharset ? QByteArray("UTF-8") : GetCharset(); // nothing detected for a new document
+        BufferedFileWriter Writer(PathName); // destroyed without committing on exceptions, which leaves the target untouched
+        EncodingStream Stream(Writer, SavingCharset);
+        if (UTF8BOM && SavingCharset == "UTF-8") { Writer.Write("\xEF\xBB\xBF"); } // kept as it was read
+        if (IsLargeRawViewShown() && FormattingOnSave && IsJSONLines() == false) {
+            GenericReader<UTF8<>, UTF16<char16_t>> JSONReader; // transcoded into UTF-16 for EncodingStream
+            PieceTable::Stream JSONIStream(LargeRawView->GetTable());
+            PrettyWriter<EncodingStream, UTF16<char16_t>, UTF16<char16_t>> JSONWriter(Stream);
+            if (JSONReader.Parse<kParseFullPrecisionFlag>(JSONIStream, JSONWriter).IsError()) {
+                throw std::runtime_error(("Save file " + PathName + " failed: the JSON can't be formatted.").toUtf8().constData());
+            }
+        }
+        else if (IsLargeRawViewShown()) { // piece by piece, so the unchanged parts are written right from the mapped file
+            LargeRawView->GetTable().ForEachPiece([&](QByteArrayView Piece) {
+                if (SavingCharset == "UTF-8") {
+                    Writer.Write(Piece);
+                    return;
+                }
+                constexpr qsizetype ChunkSize = 1 << 20;
+                while (Piece.isEmpty() == false) { // decoded chunk by chunk; each piece consists of complete UTF-8 sequences
+                    qsizetype n = std::min(Piece.size(), ChunkSize);
+                    if (n < Piece.size()) { // not inside a UTF-8 sequence, which has 3 continuation bytes at most; invalid UTF-8 (the mapped file isn't validated) is cut anywhere
+                        qsizetype Start = n;
+                        while (Start > n - 3 && (static_cast<quint8>(Piece[Start]) & 0xC0) == 0x80) { --Start; }
+                        if ((static_cast<quint8>(Piece[Start]) & 0xC0) != 0x80) { n = Start; }
+                    }
+                    Stream.Write(UTFConverter::ToUTF16(Piece.first(n)));
+                    Piece = Piece.sliced(n);
+                }
+            });
+        }
+        else if (FormattingOnSave && IsJSONLines() == false) { // formatted on the fly, without copying the whole document
+            GenericReader<UTF16<char16_t>, UTF16<char16_t>> JSONReader;
+            DocumentStream JSONIStream(RawView->document());
+            PrettyWriter<EncodingStream, UTF16<char16_t>, UTF16<char16_t>> JSONWriter(Stream);
+            if (JSONReader.Parse<kParseFullPrecisionFlag>(JSONIStream, JSONWriter).IsError()) {
+                throw std::runtime_error(("Save file " + PathName + " failed: the JSON can't be formatted.").toUtf8().constData());
+            }
+        }
+        else { // block by block, rather than a copy by toPlainText()
+            for (QTextBlock Block = RawView->document()->begin(); Block.isValid(); Block = Block.next()) {
+                Stream.Write(Block.text());
+                if (Block.next().isValid()) { Stream.Put(u'\n'); }
+            }
+        }
+        Stream.Finish();
+        const bool Replacing = MappedFile.expired() == false && QFileInfo(PathName) == QFileInfo(QString::fromUtf8(this->PathName));
+        if (Replacing) { ReleaseMappedFile(); } // the text is all written, and the file is renamed over next
+        Writer.Commit();
+        if (Replacing && SavingCharset == "UTF-8" && (FormattingOnSave == false || IsJSONLines())) { MapSavedFile(PathName); } // the saved file has the same text
+        RawView->document()->setModified(false);
+        LargeRawView->SetModified(false);
+        SetPathName(PathName.toUtf8());
+        SetFileType(QFileInfo(PathName).suffix().toUtf8());
+    }
+
+    bool TreeEditor::IsFormattingOnSave() const { return FormattingOnSave; }
+    void TreeEditor::SetFormattingOnSave(const bool Enabled) { FormattingOnSave = Enabled; }
+
+    void TreeEditor::ReleaseMappedFile() {
+        SyncPool.waitForDone(); // a text being parsed may be in the file
+        if (IsLargeRawViewShown()) { LargeRawView->DetachText(); }
+        if (const auto Index = TreeModel->GetJSONLinesIndex(); Index != nullptr) { TreeModel->RebaseJSONLines(Index->Detached()); }
+        Q_ASSERT(MappedFile.expired()); // unmapped & closed
+    }
+
+    void TreeEditor::MapSavedFile(const QString& PathName) {
+        try {
+            const std::shared_ptr<QFile> File = FileSystemAccessor::Open(PathName);
+            const QByteArray FileContentsRaw = FileSystemAccessor::GetAllMappedContents(File);
+            const QByteArrayView FileContentsUTF8 = QByteArrayView(FileContentsRaw).sliced(UTF8BOM && FileContentsRaw.startsWith("\xEF\xBB\xBF") ? 3 : 0);
+            const auto MappedContents = std::make_shared<std::pair<std::shared_ptr<QFile>, QByteArray>>(File, FileContentsRaw);
+            if (IsLargeRawViewShown() && LargeRawView->GetTable().Size() == FileContentsUTF8.size()) { LargeRawView->ResetText(FileContentsUTF8, MappedContents); }
+            if (TreeModel->GetJSONLinesIndex() != nullptr) { TreeModel->RebaseJSONLines(std::make_shared<const JSONLinesIndex>(FileContentsUTF8, MappedContents)); } // kept in memory if the records were edited
+            MappedFile = MappedContents; // expired at once if neither uses it
+        }
+        catch (const std::runtime_error& e) { qDebug() << e.what(); } // the text is kept in memory
+    }
+
+    bool TreeEditor::IsJSONLines() const {
+        const auto* const I = FileTypeToEnumID.Find(FileType);
+        return I != nullptr && I->Value == SupportedFileType::JSONLines;
+    }
+
+    void TreeEditor::FollowFile(const QString& PathName) {
+        if (QFileInfo::exists(PathName) == false) { return; } // removed, or being replaced
+        bool Replaced = false; // by a new file (e.g., log rotation), which is reloaded even if it's larger
+        if (FileWatcher->files().contains(PathName) == false) { // the watcher has stopped watching the replaced file
+            FileWatcher->addPath(PathName);
+            Replaced = true;
+        }
+        std::shared_ptr<QFile> File;
+        try { File = FileSystemAccessor::Open(PathName); }
+        catch (const std::runtime_error&) { return; } // temporarily inaccessible; retry at the next change
+        if (FileSystemAccessor::GetFileInfo(File)->birthTime() != FollowedBirthTime) { Replaced = true; } // e.g., renamed over the open file, which some watchers report as a change only
+        if (Replaced || IsJSONLines() == false || GetCharset() != "UTF-8" || File->size() < FollowOffset) { // only UTF-8 JSON Lines can be appended to; a truncated file is reloaded as well
+            OpenFile(PathName);
+            return;
+        }
+        if (File->size() == FollowOffset || File->seek(FollowOffset) == false) { return; }
+        const QByteArray Appended = File->read(File->size() - FollowOffset); // just the new bytes
+        const qsizetype CompleteSize = Appended.lastIndexOf('\n') + 1; // an incomplete last line is left to the next read
+        if (CompleteSize == 0) { return; }
+        const QByteArrayView Lines = QByteArrayView(Appended).first(CompleteSize);
+        FollowOffset += CompleteSize;
+        if (IsLargeRawViewShown()) { LargeRawView->AppendText(Lines); }
         else {
-            QTextCodec* const TextCodec = QTextCodec::codecForName(Charset);
-            std::shared_ptr<QTextDecoder> TextDecoder(TextCodec->makeDecoder());
-            const QByteArray FileContentsRaw = FileSystemAccessor::GetAllRawContents(File);
-            FileContentsUTF16 = TextDecoder->toUnicode(FileContentsRaw);
-            FileContentsUTF8 = FileContentsUTF16.toUtf8();
-        }
-        SetText(FileContentsUTF16);
-        TreeModel->FromJSON(FileContentsUTF8);
-        IntuitiveView->expandAll();
-        IntuitiveView->resizeColumnToContents(0);
-        IntuitiveView->resizeColumnToContents(1);
+            QTextCursor Cursor(RawView->document());
+            Cursor.movePosition(QTextCursor::End);
+            Cursor.insertText(UTFConverter::ToUTF16(Lines));
+        }
+        TreeModel->AppendJSONLines(Lines);
+    }
+
+    void TreeEditor::GoToRecord() {
+        const QModelIndex LinesRoot = TreeModel->index(0, 0);
+        bool Accepted = false;
+        const int N = QInputDialog::getInt(this, tr("转到记录"), tr("记录序号："), 0, 0, std::max(TreeModel->rowCount(LinesRoot) - 1, 0), 1, &Accepted);
+        if (Accepted) { GoToRecord(N); }
+    }
+
+    void TreeEditor::GoToRecord(const QtTreeModel::lsize_t N) {
+        if (IsJSONLines() == false) { return; }
+        const QModelIndex Record = TreeModel->index(N, 0, TreeModel->index(0, 0)); // O(1), and only this record is parsed
+        if (Record.isValid() == false) { return; }
+        IntuitiveView->setCurrentIndex(Record);
+        IntuitiveView->scrollTo(Record, QAbstractItemView::PositionAtTop);
+    }
+
+    void TreeEditor::GoToLine() {
+        bool Accepted = false;
+        const qsizetype LineCount = IsLargeRawViewShown() ? LargeRawView->GetTable().LineCount() : RawView->document()->blockCount();
+        const int N = QInputDialog::getInt(this, tr("转到行"), tr("行号："), 1, 1, static_cast<int>(std::min<qsizetype>(LineCount, INT_MAX)), 1, &Accepted);
+        if (Accepted) { GoToLine(N - 1); }
+    }
+
+    void TreeEditor::GoToLine(const qsizetype Line) {
+        if (IsLargeRawViewShown()) {
+            LargeRawView->SetCursor(Line, 0);
+            TabView->setCurrentWidget(LargeRawView);
+            LargeRawView->setFocus();
+            return;
+        }
+        const QTextBlock Block = RawView->document()->findBlockByNumber(static_cast<int>(Line)); // a search in the block map rather than a walk through the blocks
+        if (Block.isValid() == false) { return; }
+        QTextCursor Cursor(Block);
+        RawView->setTextCursor(Cursor);
+        RawView->centerCursor();
+        TabView->setCurrentWidget(RawView);
+        RawView->setFocus();
+    }
+
+    template<class ViewT> void TreeEditor::ShowParseError(const ViewT Text) {
+        constexpr bool IsUTF8 = std::is_same_v<ViewT, QByteArrayView>;
+        const qsizetype Offset = std::min(TreeModel->GetParseErrorOffset(), Text.size());
+        if (Offset < 0) { return; }
+        const auto LineOfError = [Text, Offset]() { // (the line, its start); the lines before it are counted rather than converted to the encoding of the view, whose line index finds the line
+            constexpr std::conditional_t<IsUTF8, char, char16_t> LineBreak = '\n';
+            return std::pair{ Text.first(Offset).count(LineBreak), Text.first(Offset).lastIndexOf(LineBreak) + 1 };
+        };
+        if (IsLargeRawViewShown()) { // whose text is in UTF-8
+            if constexpr (IsUTF8) { LargeRawView->GoToOffset(Offset); }
+            else {
+                const auto [Line, LineStart] = LineOfError();
+                LargeRawView->SetCursor(Line, UTFConverter::ToUTF8(Text.sliced(LineStart, Offset - LineStart)).size());
+            }
+            TabView->setCurrentWidget(LargeRawView);
+            emit ShouldShowMessage(tr("第 %1 行有语法错误").arg(LargeRawView->GetCursorLine() + 1));
+            return;
+        }
+        QTextCursor Cursor(RawView->document());
+        if constexpr (IsUTF8) {
+            const auto [Line, LineStart] = LineOfError();
+            Cursor.setPosition(RawView->document()->findBlockByNumber(static_cast<int>(Line)).position() + static_cast<int>(UTFConverter::ToUTF16(Text.sliced(LineStart, Offset - LineStart)).size()));
+        }
+        else { Cursor.setPosition(static_cast<int>(Offset)); }
+        RawView->setTextCursor(Cursor);
+        RawView->centerCursor();
+        TabView->setCurrentWidget(RawView);
+        emit ShouldShowMessage(tr("第 %1 行有语法错误").arg(Cursor.blockNumber() + 1));
+    }
+
+    void TreeEditor::IndexRawView() {
+        SyncedRevision = RawView->document()->revision();
+        if (IsLargeRawViewShown() || IsJSONLines() || TreeModel->GetParseErrorOffset() >= 0) { return; } // not supported, or nothing to sync
+        TreeModel->IndexTextSpans(RawView->toPlainText());
+    }
+
+    void TreeEditor::SyncRawViewEdit(const int Position, const int CharsRemoved, const int CharsAdded) {
+        const int Revision = RawView->document()->revision();
+        if (Syncing || (CharsRemoved == CharsAdded && Revision == SyncedRevision)) { return; } // e.g., the highlighter changes formats only
+        SyncedRevision = Revision;
+        TreeModel->SyncTextEdit(Position, CharsRemoved, CharsAdded, [this](const qsizetype Start, const qsizetype Length) { // only the text of the enclosing value is copied
+            QTextCursor Cursor(RawView->document());
+            Cursor.setPosition(static_cast<int>(Start));
+            if (Length < 0) { Cursor.movePosition(QTextCursor::End, QTextCursor::KeepAnchor); }
+            else { Cursor.setPosition(static_cast<int>(Start + Length), QTextCursor::KeepAnchor); }
+            return Cursor.selectedText().replace(QChar::ParagraphSeparator, u'\n'); // the blocks are separated by U+2029 in selections
+        });
+    }
+
+    void TreeEditor::SyncTreeEdit(const qsizetype Position, const qsizetype Length, const QString& Text) {
+        if (IsLargeRawViewShown()) { return; } // never indexed
+        QTextCursor Cursor(RawView->document());
+        Cursor.setPosition(static_cast<int>(Position));
+        Cursor.setPosition(static_cast<int>(Position + Length), QTextCursor::KeepAnchor);
+        Syncing = true;
+        Cursor.insertText(Text); // an undoable edit, as if it were typed
+        Syncing = false;
+        SyncedRevision = RawView->document()->revision();
+    }
+
+    void TreeEditor::SyncLargeRawViewEdit() {
+        if (IsLargeRawViewShown() == false) { return; }
+        if (LargeRawViewParsing) { // the text is parsed again with the latest edits once this parse ends
+            LargeRawViewSyncPending = true;
+            return;
+        }
+        LargeRawViewParsing = true;
+        LargeRawViewSyncPending = false;
+        const quint64 Revision = LargeRawViewRevision;
+        SyncPool.start([this, Revision, JSONLines = IsJSONLines(), Text = PieceTable::Stream(LargeRawView->GetTable())]() mutable { // the stream keeps the text as it is now, while the typing goes on
+            std::shared_ptr<QtTreeModel::Node> Tree;
+            std::shared_ptr<const JSONLinesIndex> Index;
+            if (JSONLines) { // the records are indexed in a copy of the text, and parsed as they're shown
+                const auto Joined = std::make_shared<const QByteArray>(Text.Text());
+                Index = std::make_shared<const JSONLinesIndex>(*Joined, Joined);
+            }
+            else { Tree = QtTreeModel::TreeFromJSON(Text); }
+            QMetaObject::invokeMethod(this, [this, Revision, Tree = std::move(Tree), Index = std::move(Index)]() {
+                LargeRawViewParsing = false;
+                if (IsLargeRawViewShown() && Revision == LargeRawViewRevision && (Tree != nullptr || Index != nullptr)) { // the tree is kept until the text parses again
+                    const QList<QList<int>> Expanded = IntuitiveView->GetExpandedRows(); // the model is reset, but the same nodes are shown
+                    if (Index != nullptr) { TreeModel->FromJSONLines(Index); }
+                    else { TreeModel->FromTree(Tree.get()); }
+                    IntuitiveView->SetExpandedRows(Expanded);
+                }
+                if (LargeRawViewSyncPending) { SyncLargeRawViewEdit(); }
+            }, Qt::QueuedConnection);
+        });
+    }
+
+    bool TreeEditor::IsLargeRawViewShown() const { return TabView->indexOf(LargeRawView) >= 0; }
+
+    void TreeEditor::ShowLargeRawView(const bool Shown) {
+        if (IsLargeRawViewShown() == Shown) { return; }
+        if (Shown == false) { LargeRawView->SetText({}); } // release the previous text (e.g., the mapped file)
+        QWidget* const Hidden = Shown ? static_cast<QWidget*>(RawView) : LargeRawView;
+        const int Index = TabView->indexOf(Hidden);
+        const bool Current = TabView->currentIndex() == Index;
+        TabView->removeTab(Index);
+        Hidden->setParent(this); // still destroyed with this tree editor
+        Hidden->hide();
+        TabView->insertTab(Index, Shown ? static_cast<QWidget*>(LargeRawView) : RawView, tr("原始"));
+        if (Current) { TabView->setCurrentIndex(Index); }
+    }
+
+    void TreeEditor::SetRawViewText(const QByteArrayView UTF8, std::shared_ptr<const void> Owner) {
+        if (UTF8.size() <= RawViewSizeLimit) { // the number of characters is no more than the number of bytes
+            SetText(UTFConverter::ToUTF16(UTF8));
+            return;
+        }
+        RawView->clear(); // release the previous document
+        LargeRawViewSyncTimer->stop(); // the edits of the previous text are dropped
+        LargeRawViewSyncPending = false;
+        ++LargeRawViewRevision; // so is the tree being parsed from it
+        LargeRawView->SetText(UTF8, std::move(Owner)); // only the line breaks are indexed; the text isn't copied
+        ShowLargeRawView(true);
+    }
+
+    void TreeEditor::BuildCharsetMenu() {
+        Menu::Charset = new QMenu(tr("字符集"));
+        AddCharsetAction(Menu::Charset, AutoCharset)->setStatusTip(tr("打开文件时自动检测字符集"));
+        Menu::Charset->addSeparator();
+        for (const char* const Charset: CommonCharsets) { AddCharsetAction(Menu::Charset, Charset); }
+        Menu::Charset->addSeparator();
+        Menu::AllCharsets = Menu::Charset->addMenu(tr("全部字符集"));
+        Menu::AllCharsets->addAction(tr("正在加载……"))->setEnabled(false); // replaced when the list is ready
+
+        QThreadPool::globalInstance()->start([]() { // QTextCodec guards its registry with a mutex
+            auto AvailableCharsets = QTextCodec::availableCodecs();
+            std::sort(AvailableCharsets.begin(), AvailableCharsets.end());
+            AvailableCharsets.erase(std::unique(AvailableCharsets.begin(), AvailableCharsets.end()), AvailableCharsets.end());
+            QMetaObject::invokeMethod(Menu::AllCharsets, [AvailableCharsets = std::move(AvailableCharsets)]() { // QActions are created in the GUI thread
+                Menu::AllCharsets->clear();
+                for (const auto& Charset: AvailableCharsets) { AddCharsetAction(Menu::AllCharsets, Charset); }
+            }, Qt::QueuedConnection);
+        });
+    }
+
+    void TreeEditor::ExpandTree() {
+        if (IsJSONLines()) { IntuitiveView->Expand({ .MaxDepth = 1, .RowBudget = -1, .LargeChildCount = -1 }); } // only the list of records, since expanding a record parses it
+        else { IntuitiveView->Expand(); } // expandAll() would lay out every row of a large document
+        IntuitiveView->FitColumns(); // resizeColumnToContents() would measure every shown row
     }
 } // namespace WritingMaterialsManager
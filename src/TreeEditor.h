@@ -1,16 +1,19 @@
 #ifndef WRITING_MATERIALS_MANAGER_EDITOR_H
 #define WRITING_MATERIALS_MANAGER_EDITOR_H
 
-#include <unordered_map>
-
+#include <QDateTime>
+#include <QFileSystemWatcher>
 #include <QFont>
 #include <QMenu>
 #include <QSyntaxHighlighter>
 #include <QTabWidget>
+#include <QThreadPool>
+#include <QTimer>
 #include <QTreeView>
 #include <QWidget>
 
 #include <Algorithm.h>
+#include "LargeTextView.h"
 #include "QtTreeModel.h"
 #include "TextArea.h"
 #include "TextFormatter.h"
@@ -24,11 +27,15 @@ namespace WritingMaterialsManager {
         enum class SupportedFileType : size_t { // file types supported by the tree editor
             JSON = 1,
             MongoDBExtendedJSON = 2,
+            JSONLines = 3,
         };
 
+        inline static constexpr char AutoCharset[] = "Auto"; // detect the charset of each file when opening it; an explicitly set charset is always trusted
+
         QTabWidget* const TabView; // the main tab widget containing IntuitiveView and RawView
         TreeView* const IntuitiveView; // show the tree structure of the open JSON
         TextArea* const RawView; // show the raw content of the open JSON
+        LargeTextView* const LargeRawView; // show the raw content instead of RawView if it's too large for RawView
 
         explicit TreeEditor(const QByteArray& FileType = "<File Type>", const std::shared_ptr<QtTreeModel>& TreeModel = std::make_shared<QtTreeModel>(), QWidget* const parent = nullptr);
         ~TreeEditor();
@@ -41,24 +48,44 @@ namespace WritingMaterialsManager {
         void ShouldUpdatePathName();
         void ShouldUpdateFileType();
         void ShouldUpdateCharset();
+        void ShouldShowMessage(const QString& Message); // e.g., on the status bar
     public slots:
         void ArrangeContentView(); // format & highlight the displaying content
         void OpenFile(); // open a file and show its content using both IntuitiveView and RawView in this tree editor
         void OpenFile(const QString& PathName);
+        void SaveFile(); // save to the open file, or to a file chosen by the user if there's none
+        void SaveFileAs(); // save to a file chosen by the user
+        void SaveFile(const QString& PathName); // stream RawView out in the charset of this tree editor; the file is replaced atomically, and throws std::runtime_error on failure
 
         QByteArray GetPathName() const; // get the pathname of the open file of this tree editor
         void SetPathName(const QByteArray& FileName); // set the pathname of this tree editor as the pathname of the open file
         QByteArray GetFileType() const; // get the extension of the open file of this tree editor
         void SetFileType(const QByteArray& FileType); // set the file type of this tree editor as the extension of the open file so as to perform the proper operations
-        QByteArray GetCharset() const;
-        void SetCharset(); // This slot is for QAction::triggered()
+        QByteArray GetCharset() const; // the detected charset of the open file if the charset is AutoCharset
+        void SetCharset(QAction* const Action); // This slot is for QMenu::triggered()
         void SetCharset(const QByteArray& Charset); // set the charset of this tree editor as the proper charset for appropriately reading the content of the open file
+        bool IsFollowing() const;
+        void SetFollowing(const bool Enabled); // follow mode: new lines appended to the open JSON Lines file are parsed and added as new rows; other files are reloaded on change
+        bool IsFormattingOnSave() const;
+        void SetFormattingOnSave(const bool Enabled); // format JSON while saving it
+        void GoToRecord(); // This slot is for QAction::triggered()
+        void GoToRecord(const QtTreeModel::lsize_t N); // select & show the Nth record of the open JSON Lines file
+        void GoToLine(); // This slot is for QAction::triggered()
+        void GoToLine(const qsizetype Line); // move the cursor of the raw view to the beginning of the line (0-based) in O(log n) time
     protected:
         void contextMenuEvent(QContextMenuEvent* const Event) override; // context menu event handler
     private:
-        static const std::unordered_map<QByteArray, SupportedFileType, CaseInsensitiveHasher, CaseInsensitiveStringComparator> FileTypeToEnumID; // mainly for switch-case statement so far.
+        inline static constexpr auto FileTypeToEnumID = MakeStaticStringMap<SupportedFileType>({
+            { "JSON",                  SupportedFileType::JSON },
+            { "MongoDB Extended JSON", SupportedFileType::MongoDBExtendedJSON },
+            { "JSONL",                 SupportedFileType::JSONLines },
+            { "NDJSON",                SupportedFileType::JSONLines },
+            { "JSON Lines",            SupportedFileType::JSONLines },
+        }); // mainly for switch-case statement so far. Built at compile time.
+        inline static constexpr qsizetype RawViewSizeLimit = 64 << 20; // RawView doesn't scale to huge text, so larger text (in characters) is shown in LargeRawView
         struct Menu { // menu items
-            inline static QMenu* Charset; // charset menu item
+            inline static QMenu* Charset; // charset menu item, built at the 1st popup of a context menu
+            inline static QMenu* AllCharsets; // submenu of Charset, filled once the available charsets are listed in the background
             Menu() = delete;
             Menu(const Menu&) = delete;
             Menu(Menu&&) = delete;
@@ -67,7 +94,12 @@ namespace WritingMaterialsManager {
         };
         struct MenuAction { // actions of menu items
             inline static QAction* Open;
-            inline static QList<QAction*> SetCharset;
+            inline static QAction* Save;
+            inline static QAction* SaveAs;
+            inline static QAction* FormatOnSave;
+            inline static QAction* Follow;
+            inline static QAction* GoToRecord;
+            inline static QAction* GoToLine;
             MenuAction() = delete;
             MenuAction(const MenuAction&) = delete;
             MenuAction(MenuAction&&) = delete;
@@ -78,9 +110,39 @@ namespace WritingMaterialsManager {
         QByteArray PathName{}; // the pathname of the open file
         QByteArray FileType{}; // the extension of the open file
         QByteArray Charset{}; // the charset used for reading the open file
+        QByteArray DetectedCharset{}; // the charset of the open file detected in the AutoCharset mode
+        bool UTF8BOM = false; // whether the open file begins with the BOM of UTF-8, which isn't shown but written back on save
+        std::weak_ptr<const void> MappedFile; // the open file mapped for LargeRawView & the index of JSON Lines, which is released before the file is replaced on save
+        bool Following = false; // whether the follow mode is on
+        bool FormattingOnSave = false;
+        qint64 FollowOffset = 0; // the offset of the 1st byte not read yet, which is always at the beginning of a line in the follow mode
+        QFileSystemWatcher* FileWatcher = nullptr; // created when the follow mode is turned on for the 1st time
+        QDateTime FollowedBirthTime{}; // of the open file, which tells a file replaced by another one (e.g., by log rotation) from a grown one; invalid if the file system doesn't record it
+        bool Syncing = false; // whether an edit is being copied between RawView & the tree, which mustn't be copied back
+        int SyncedRevision = -1; // the revision of the document of RawView when it was synced at last
+        QTimer* const LargeRawViewSyncTimer; // delays SyncLargeRawViewEdit() until the typing pauses
+        quint64 LargeRawViewRevision = 0; // counts the edits & the texts of LargeRawView, so that the tree parsed from a stale text is dropped
+        bool LargeRawViewParsing = false; // whether the text of LargeRawView is being parsed in SyncPool
+        bool LargeRawViewSyncPending = false; // whether the typing paused again during the parse, which is done again after it
+        QThreadPool SyncPool; // parses the text of LargeRawView off the GUI thread; its own pool, so that it can be waited for on destruction
         std::shared_ptr<TextFormatter> Formatter; // formatter for the open file
         std::shared_ptr<TextHighlighter> Highlighter; // highlighter for the open file
         std::shared_ptr<QtTreeModel> TreeModel; // for IntuitiveView
+
+        static void BuildCharsetMenu(); // common charsets are shown at once, while all the others are listed & sorted in a worker thread
+        void ExpandTree(); // expand IntuitiveView after the tree model is reset
+        bool IsLargeRawViewShown() const;
+        void ShowLargeRawView(const bool Shown); // swap LargeRawView & RawView in TabView
+        void SetRawViewText(const QByteArrayView UTF8, std::shared_ptr<const void> Owner); // Owner keeps UTF8 valid if it's shown in LargeRawView
+        template<class ViewT> void ShowParseError(const ViewT Text); // move the cursor of the raw view to the syntax error found in Text (the open JSON) by the tree model
+        void IndexRawView(); // map the tree to RawView, so that the edits of either side are synced to the other incrementally
+        void SyncRawViewEdit(const int Position, const int CharsRemoved, const int CharsAdded); // patch the tree for an edit of RawView
+        void SyncTreeEdit(const qsizetype Position, const qsizetype Length, const QString& Text); // patch RawView for an edit of the tree
+        void SyncLargeRawViewEdit(); // rebuild the tree from the edited text of LargeRawView, which isn't indexed, in SyncPool; the tree is swapped in, with the same nodes expanded, once it's built
+        bool IsJSONLines() const;
+        void ReleaseMappedFile(); // copy the text still in MappedFile into memory, so that the file is unmapped & closed (a mapped file can't be replaced on Windows)
+        void MapSavedFile(const QString& PathName); // map the file just saved with the same text as this tree editor in place of the copies of ReleaseMappedFile()
+        void FollowFile(const QString& PathName); // read the lines appended since the last read
     };
 } // namespace WritingMaterialsManager
 
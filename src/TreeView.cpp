@@ -1,8 +1,196 @@
 #include "TreeView.h"
 
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+#include <QHeaderView>
+#include <QKeyEvent>
+#include <QRandomGenerator>
+
 namespace WritingMaterialsManager {
+    void TreeView::Expand(const QModelIndex& Root, const ExpandPolicy& Policy) {
+        const QAbstractItemModel* const Model = model();
+        if (Model == nullptr) { return; }
+        QList<QModelIndex> ToBeExpanded;
+        std::queue<std::pair<QModelIndex, int>> q; // (node, depth relative to Root's children)
+        qsizetype Shown = 0; // rows shown after expanding the nodes in ToBeExpanded
+        const auto Visit = [&](const QModelIndex& Index, const int Depth) { // expand Index if it's within the limits
+            if (Policy.MaxDepth >= 0 && Depth >= Policy.MaxDepth) { return false; }
+            if (Model->hasChildren(Index) == false) { return false; }
+            const int RowCount = Model->rowCount(Index);
+            if (Policy.LargeChildCount >= 0 && RowCount > Policy.LargeChildCount) { return false; } // smart expand: skip large arrays/objects
+            if (Policy.RowBudget >= 0 && Shown + RowCount > Policy.RowBudget) { return false; }
+            Shown += RowCount;
+            ToBeExpanded.emplace_back(Index);
+            if (Policy.MaxDepth < 0 || Depth + 1 < Policy.MaxDepth) { // the children may be expanded as well
+                for (int i = 0; i < RowCount; ++i) { q.emplace(Model->index(i, 0, Index), Depth + 1); }
+            }
+            return true;
+        };
+        if (Root.isValid()) {
+            if (Visit(Root, -1) == false) { return; } // Root itself is always considered, so that the smart expand works on any node
+        }
+        else {
+            const int RowCount = Model->rowCount(rootIndex());
+            for (int i = 0; i < RowCount; ++i) { q.emplace(Model->index(i, 0, rootIndex()), 0); }
+        }
+        while (q.empty() == false) { // BFS
+            const auto [Index, Depth] = q.front();
+            q.pop();
+            Visit(Index, Depth);
+            if (Policy.RowBudget >= 0 && Shown >= Policy.RowBudget) { break; }
+        }
+        const bool Fitting = std::exchange(FittingColumns, false); // FitChildren() isn't called for each node; the nodes share 1 sample
+        for (const QModelIndex& Index: ToBeExpanded) { expand(Index); } // only recorded until the next layout if the model has just been reset
+        FittingColumns = Fitting;
+        FitChildrenOf(ToBeExpanded);
+    }
+
+    void TreeView::Expand(const ExpandPolicy& Policy) { Expand(QModelIndex(), Policy); }
+    void TreeView::Expand() { Expand(QModelIndex(), Policy); }
+
+    QList<QList<int>> TreeView::GetExpandedRows() const {
+        const QAbstractItemModel* const Model = model();
+        QList<QList<int>> Paths;
+        if (Model == nullptr) { return Paths; }
+        std::queue<std::pair<QModelIndex, qsizetype>> q; // (expanded node, its path in Paths); only the children of the expanded nodes are visited
+        q.emplace(rootIndex(), -1);
+        while (q.empty() == false) { // BFS
+            const auto [Parent, Path] = q.front();
+            q.pop();
+            const int RowCount = Model->rowCount(Parent);
+            for (int i = 0; i < RowCount; ++i) {
+                const QModelIndex Index = Model->index(i, 0, Parent);
+                if (isExpanded(Index) == false) { continue; }
+                QList<int> Rows = Path < 0 ? QList<int>() : Paths[Path];
+                Rows.emplace_back(i);
+                Paths.emplace_back(std::move(Rows));
+                q.emplace(Index, Paths.size() - 1);
+            }
+        }
+        return Paths;
+    }
+
+    void TreeView::SetExpandedRows(const QList<QList<int>>& Paths) {
+        const QAbstractItemModel* const Model = model();
+        if (Model == nullptr) { return; }
+        QList<QModelIndex> ToBeExpanded;
+        for (const QList<int>& Path: Paths) {
+            QModelIndex Index = rootIndex();
+            for (const int Row: Path) {
+                Index = Model->index(Row, 0, Index);
+                if (Index.isValid() == false) { break; } // the row doesn't exist anymore
+            }
+            if (Index.isValid()) { ToBeExpanded.emplace_back(Index); }
+        }
+        const bool Fitting = std::exchange(FittingColumns, false);
+        for (const QModelIndex& Index: ToBeExpanded) { expand(Index); }
+        FittingColumns = Fitting;
+        FitChildrenOf(ToBeExpanded);
+    }
+
+    TreeView::ExpandPolicy TreeView::GetExpandPolicy() const { return Policy; }
+    void TreeView::SetExpandPolicy(const ExpandPolicy& Policy) { this->Policy = Policy; }
+
+    void TreeView::FitColumns(const int SampleSize) {
+        const QAbstractItemModel* const Model = model();
+        if (Model == nullptr) { return; }
+        QList<QModelIndex> Rows;
+        Rows.reserve(SampleSize);
+        QModelIndex Top = indexAt(QPoint(0, 0)); // rows on the screen first
+        if (Top.isValid() == false) { Top = Model->index(0, 0, rootIndex()); }
+        for (QModelIndex i = Top; i.isValid() && Rows.size() < SampleSize / 2; i = indexBelow(i)) { Rows.emplace_back(i); }
+        if (Model->rowCount(rootIndex()) > 0) {
+            QRandomGenerator* const Random = QRandomGenerator::global();
+            while (Rows.size() < SampleSize) { // random walks down the expanded nodes; every node on the path is a shown row, and the repeated ones are cached
+                QModelIndex i = Model->index(Random->bounded(Model->rowCount(rootIndex())), 0, rootIndex());
+                Rows.emplace_back(i);
+                while (Rows.size() < SampleSize && isExpanded(i) && Model->rowCount(i) > 0) {
+                    i = Model->index(Random->bounded(Model->rowCount(i)), 0, i);
+                    Rows.emplace_back(i);
+                }
+            }
+        }
+        for (int c = 0; c < Model->columnCount(rootIndex()); ++c) { setColumnWidth(c, header()->sectionSizeHint(c)); } // at least the width of the header
+        WidenColumns(Rows);
+        FittingColumns = true;
+    }
+
+    void TreeView::setModel(QAbstractItemModel* const Model) {
+        for (const auto& Connection: ModelConnections) { disconnect(Connection); }
+        ModelConnections.clear();
+        ItemWidth.clear();
+        QTreeView::setModel(Model);
+        if (Model == nullptr) { return; }
+        const auto Clear = [this]() { ItemWidth.clear(); }; // the internal pointers may be reused
+        ModelConnections.emplace_back(connect(Model, &QAbstractItemModel::modelReset, this, Clear));
+        ModelConnections.emplace_back(connect(Model, &QAbstractItemModel::layoutChanged, this, Clear));
+        ModelConnections.emplace_back(connect(Model, &QAbstractItemModel::dataChanged, this, Clear));
+        ModelConnections.emplace_back(connect(Model, &QAbstractItemModel::rowsRemoved, this, Clear));
+        ModelConnections.emplace_back(connect(Model, &QAbstractItemModel::rowsMoved, this, Clear));
+        ModelConnections.emplace_back(connect(this, &QTreeView::expanded, this, &TreeView::FitChildren));
+    }
+
+    int TreeView::MeasureWidth(const QModelIndex& Index) {
+        const ItemKey Key{ Index.internalId(), Index.row(), Index.column() };
+        auto Width = ItemWidth.constFind(Key);
+        if (Width == ItemWidth.constEnd()) {
+            QStyleOptionViewItem Option;
+            initViewItemOption(&Option);
+            Width = ItemWidth.insert(Key, itemDelegateForIndex(Index)->sizeHint(Option, Index).width());
+        }
+        if (Index.column() != treePosition()) { return *Width; } // only the column of the tree is indented
+        int Depth = rootIsDecorated() ? 1 : 0;
+        for (QModelIndex i = Index.parent(); i.isValid() && i != rootIndex(); i = i.parent()) { ++Depth; }
+        return *Width + Depth * indentation();
+    }
+
+    void TreeView::WidenColumns(const QList<QModelIndex>& Rows) {
+        const QAbstractItemModel* const Model = model();
+        for (const QModelIndex& Row: Rows) {
+            for (int c = 0; c < Model->columnCount(Row.parent()); ++c) {
+                if (isColumnHidden(c)) { continue; }
+                const int Width = MeasureWidth(Row.siblingAtColumn(c));
+                if (Width > columnWidth(c)) { setColumnWidth(c, Width); }
+            }
+        }
+    }
+
+    void TreeView::FitChildren(const QModelIndex& Parent) { FitChildrenOf({ Parent }); }
+
+    void TreeView::FitChildrenOf(const QList<QModelIndex>& Parents) {
+        if (FittingColumns == false || Parents.isEmpty()) { return; }
+        const QAbstractItemModel* const Model = model();
+        QList<QModelIndex> Rows;
+        bool Sampled = false; // whether some children are left out of the 1st rows
+        for (const QModelIndex& Parent: Parents) { // the rows likely to be seen first
+            if (Sampled) { break; }
+            const int RowCount = Model->rowCount(Parent);
+            for (int i = 0; i < RowCount && Sampled == false; ++i) {
+                if (Rows.size() < DefaultSampleSize / 2) { Rows.emplace_back(Model->index(i, 0, Parent)); }
+                else { Sampled = true; }
+            }
+        }
+        QRandomGenerator* const Random = QRandomGenerator::global();
+        for (int i = 0; Sampled && i < DefaultSampleSize / 2; ++i) { // random rows of random nodes
+            const QModelIndex& Parent = Parents[Random->bounded(static_cast<int>(Parents.size()))];
+            if (const int RowCount = Model->rowCount(Parent); RowCount > 0) { Rows.emplace_back(Model->index(Random->bounded(RowCount), 0, Parent)); }
+        }
+        WidenColumns(Rows);
+    }
+
     void TreeView::mousePressEvent(QMouseEvent* const E) {
         QTreeView::mousePressEvent(E);
         emit MouseDown();
     }
+
+    void TreeView::keyPressEvent(QKeyEvent* const E) {
+        if (E->key() == Qt::Key_Asterisk && currentIndex().isValid()) { // QTreeView would expand the whole subtree, which may be huge
+            Expand(currentIndex(), Policy);
+            E->accept();
+            return;
+        }
+        QTreeView::keyPressEvent(E);
+    }
 }
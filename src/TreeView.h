@@ -1,17 +1,70 @@
 #ifndef WRITING_MATERIALS_MANAGER_TREEVIEW_H
 #define WRITING_MATERIALS_MANAGER_TREEVIEW_H
 
+#include <QHash>
 #include <QTreeView>
 
 namespace WritingMaterialsManager {
     class TreeView : public QTreeView {
     Q_OBJECT
     public:
+        struct ExpandPolicy { // how much of a tree is expanded by Expand(); the rest is expanded on demand. Negative limits are unlimited.
+            int MaxDepth = -1; // nodes at this depth or deeper are collapsed (the top-level nodes are at depth 0)
+            int RowBudget = 10000; // no more nodes are expanded once this many rows would be shown
+            int LargeChildCount = 1000; // nodes (e.g., arrays) with more children than this are collapsed
+        };
+
         using QTreeView::QTreeView;
 
+        /**
+         * Expand the nodes level by level (so that shallow nodes are expanded first) until the limits of the policy are reached.
+         * Unlike expandAll(), the nodes beyond the limits aren't even visited, and the view is laid out just once.
+         * @param Root The subtree to be expanded; the whole tree if invalid.
+         * @param Policy
+         */
+        void Expand(const QModelIndex& Root, const ExpandPolicy& Policy);
+        void Expand(const ExpandPolicy& Policy);
+        void Expand(); // with the policy of this view
+        QList<QList<int>> GetExpandedRows() const; // the paths of rows from the root to each expanded node, parents first, e.g., to keep them expanded when the model is rebuilt
+        void SetExpandedRows(const QList<QList<int>>& Paths); // expand the nodes at the paths which still exist
+        ExpandPolicy GetExpandPolicy() const;
+        void SetExpandPolicy(const ExpandPolicy& Policy); // also used by the "smart expand" key (*) on the current node
+
+        inline static constexpr int DefaultSampleSize = 256;
+
+        /**
+         * Fit the width of each column to the rows at the top of the viewport plus rows picked at random among the shown ones,
+         * unlike resizeColumnToContents() which measures every row. The widths of the items are cached until the model changes.
+         * After this, the columns are widened (but never narrowed) to fit the children of each node expanded, which are sampled as well.
+         * @param SampleSize The max number of rows measured.
+         */
+        void FitColumns(const int SampleSize = DefaultSampleSize);
+
+        void setModel(QAbstractItemModel* const Model) override;
+
         void mousePressEvent(QMouseEvent* const E) override;
+        void keyPressEvent(QKeyEvent* const E) override;
     signals:
         void MouseDown();
+    private:
+        struct ItemKey { // an item is identified by its row as well, since the rows of a model may share the internal pointer (e.g., the lazy records of QtTreeModel)
+            quintptr InternalID;
+            int Row;
+            int Column;
+
+            bool operator==(const ItemKey&) const = default;
+            friend size_t qHash(const ItemKey& Key, const size_t Seed = 0) noexcept { return qHashMulti(Seed, Key.InternalID, Key.Row, Key.Column); }
+        };
+
+        ExpandPolicy Policy{};
+        QHash<ItemKey, int> ItemWidth; // the widths of the measured items, without the indentation
+        QList<QMetaObject::Connection> ModelConnections; // for clearing ItemWidth
+        bool FittingColumns = false; // whether FitColumns() has been called
+
+        int MeasureWidth(const QModelIndex& Index); // the width needed by the item, including the indentation
+        void WidenColumns(const QList<QModelIndex>& Rows); // widen the columns to fit the items of the rows
+        void FitChildren(const QModelIndex& Parent); // for the signal expanded()
+        void FitChildrenOf(const QList<QModelIndex>& Parents); // measure at most DefaultSampleSize of the children of all the nodes, however many they are
     };
 }
 
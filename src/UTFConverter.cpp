@@ -0,0 +1,349 @@
+#include "UTFConverter.h"
+
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WMM_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define WMM_TARGET_AVX2 // MSVC accepts AVX2 intrinsics in any function
+#else
+#define WMM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace WritingMaterialsManager {
+    namespace {
+        using u8 = unsigned char;
+
+        constexpr uint64_t HighBits = 0x8080808080808080;
+
+        // ---------------- scalar kernels ----------------
+
+        qsizetype ASCIIPrefixLengthScalar(const u8* const s, const qsizetype n) noexcept {
+            qsizetype i = 0;
+            for (uint64_t w; i + 8 <= n; i += 8) {
+                std::memcpy(&w, s + i, 8);
+                if ((w & HighBits) != 0) { break; }
+            }
+            for (; i < n; ++i) { if (s[i] >= 0x80) { return i; } }
+            return n;
+        }
+
+        // Validate 1 non-ASCII sequence at s[i]. Return its length, or 0 if it's invalid.
+        qsizetype ValidateSequence(const u8* const s, const qsizetype i, const qsizetype n) noexcept {
+            const u8 c = s[i];
+            qsizetype Length;
+            u8 Min = 0x80, Max = 0xBF; // range of the 2nd byte, which excludes overlong forms, surrogates and code points beyond U+10FFFF
+            if (c >= 0xC2 && c <= 0xDF) { Length = 2; }
+            else if (c >= 0xE0 && c <= 0xEF) {
+                Length = 3;
+                if (c == 0xE0) { Min = 0xA0; }
+                else if (c == 0xED) { Max = 0x9F; }
+            }
+            else if (c >= 0xF0 && c <= 0xF4) {
+                Length = 4;
+                if (c == 0xF0) { Min = 0x90; }
+                else if (c == 0xF4) { Max = 0x8F; }
+            }
+            else { return 0; }
+            if (i + Length > n || s[i + 1] < Min || s[i + 1] > Max) { return 0; }
+            for (qsizetype j = 2; j < Length; ++j) { if ((s[i + j] & 0xC0) != 0x80) { return 0; } }
+            return Length;
+        }
+
+        bool IsValidUTF8Scalar(const u8* const s, const qsizetype n) noexcept {
+            for (qsizetype i = 0; i < n;) {
+                if (s[i] < 0x80) {
+                    i += ASCIIPrefixLengthScalar(s + i, n - i);
+                    continue;
+                }
+                const qsizetype Length = ValidateSequence(s, i, n);
+                if (Length == 0) { return false; }
+                i += Length;
+            }
+            return true;
+        }
+
+        // Decode 1 non-ASCII sequence of VALID UTF-8 at s[i]. Return its length.
+        inline qsizetype DecodeSequence(const u8* const s, const qsizetype i, char16_t*& d) noexcept {
+            const u8 c = s[i];
+            if (c < 0xE0) {
+                *d++ = static_cast<char16_t>((c & 0x1F) << 6 | (s[i + 1] & 0x3F));
+                return 2;
+            }
+            if (c < 0xF0) {
+                *d++ = static_cast<char16_t>((c & 0x0F) << 12 | (s[i + 1] & 0x3F) << 6 | (s[i + 2] & 0x3F));
+                return 3;
+            }
+            const char32_t u = (c & 0x07) << 18 | (s[i + 1] & 0x3F) << 12 | (s[i + 2] & 0x3F) << 6 | (s[i + 3] & 0x3F);
+            *d++ = static_cast<char16_t>(0xD7C0 + (u >> 10));
+            *d++ = static_cast<char16_t>(0xDC00 | (u & 0x3FF));
+            return 4;
+        }
+
+        char16_t* UTF8ToUTF16Scalar(const u8* const s, const qsizetype n, char16_t* d) noexcept { // the input must be valid
+            for (qsizetype i = 0; i < n;) {
+                if (s[i] < 0x80) { // ASCII run
+                    for (uint64_t w; i + 8 <= n; i += 8, d += 8) {
+                        std::memcpy(&w, s + i, 8);
+                        if ((w & HighBits) != 0) { break; }
+                        for (int k = 0; k < 8; ++k) { d[k] = s[i + k]; }
+                    }
+                    for (; i < n && s[i] < 0x80; ++i) { *d++ = s[i]; }
+                    continue;
+                }
+                i += DecodeSequence(s, i, d);
+            }
+            return d;
+        }
+
+        // Encode 1 non-ASCII code point at s[i]. Return the number of code units consumed, or 0 for a lone surrogate.
+        inline qsizetype EncodeCodePoint(const char16_t* const s, const qsizetype i, const qsizetype n, char*& d) noexcept {
+            const char16_t c = s[i];
+            if (c < 0x800) {
+                *d++ = static_cast<char>(0xC0 | c >> 6);
+                *d++ = static_cast<char>(0x80 | (c & 0x3F));
+                return 1;
+            }
+            if (c < 0xD800 || c > 0xDFFF) {
+                *d++ = static_cast<char>(0xE0 | c >> 12);
+                *d++ = static_cast<char>(0x80 | (c >> 6 & 0x3F));
+                *d++ = static_cast<char>(0x80 | (c & 0x3F));
+                return 1;
+            }
+            if (c > 0xDBFF || i + 1 >= n || s[i + 1] < 0xDC00 || s[i + 1] > 0xDFFF) { return 0; }
+            const char32_t u = 0x10000 + ((c - 0xD800) << 10 | (s[i + 1] - 0xDC00));
+            *d++ = static_cast<char>(0xF0 | u >> 18);
+            *d++ = static_cast<char>(0x80 | (u >> 12 & 0x3F));
+            *d++ = static_cast<char>(0x80 | (u >> 6 & 0x3F));
+            *d++ = static_cast<char>(0x80 | (u & 0x3F));
+            return 2;
+        }
+
+        char* UTF16ToUTF8Scalar(const char16_t* const s, const qsizetype n, char* d) noexcept { // nullptr if there's a lone surrogate
+            for (qsizetype i = 0; i < n;) {
+                if (s[i] < 0x80) {
+                    *d++ = static_cast<char>(s[i++]);
+                    continue;
+                }
+                const qsizetype Count = EncodeCodePoint(s, i, n, d);
+                if (Count == 0) { return nullptr; }
+                i += Count;
+            }
+            return d;
+        }
+
+#ifdef WMM_X86
+        // ---------------- AVX2 kernels ----------------
+
+        WMM_TARGET_AVX2 qsizetype ASCIIPrefixLengthAVX2(const u8* const s, const qsizetype n) noexcept {
+            qsizetype i = 0;
+            for (; i + 32 <= n; i += 32) {
+                const unsigned Mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i)))); // MSB of each byte
+                if (Mask != 0) { return i + std::countr_zero(Mask); }
+            }
+            return i + ASCIIPrefixLengthScalar(s + i, n - i);
+        }
+
+        // UTF-8 validation by 3 nibble lookups per byte, see J. Keiser & D. Lemire, Validating UTF-8 in less than one instruction per byte, 2021.
+        namespace Lookup {
+            constexpr u8 TooShort = 1 << 0, TooLong = 1 << 1, Overlong3 = 1 << 2, TooLarge = 1 << 3, Surrogate = 1 << 4, Overlong2 = 1 << 5, TooLarge1000 = 1 << 6, Overlong4 = 1 << 6, TwoConts = 1 << 7;
+            constexpr u8 Carry = TooShort | TooLong | TwoConts;
+        }
+
+        WMM_TARGET_AVX2 inline __m256i Lookup16(const __m256i Nibbles, const __m256i Table) noexcept { return _mm256_shuffle_epi8(Table, Nibbles); }
+        WMM_TARGET_AVX2 inline __m256i Table16(const u8 (&t)[16]) noexcept {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t));
+            return _mm256_broadcastsi128_si256(x);
+        }
+        template<int N> WMM_TARGET_AVX2 inline __m256i Previous(const __m256i Input, const __m256i PreviousInput) noexcept { // Input shifted by N bytes, with the tail of PreviousInput
+            return _mm256_alignr_epi8(Input, _mm256_permute2x128_si256(PreviousInput, Input, 0x21), 16 - N);
+        }
+
+        WMM_TARGET_AVX2 bool IsValidUTF8AVX2(const u8* const s, const qsizetype n) noexcept {
+            using namespace Lookup;
+            static constexpr u8 Byte1High[16] = {
+                TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, // 0___ ____ (ASCII)
+                TwoConts, TwoConts, TwoConts, TwoConts, // 10__ ____ (continuation)
+                TooShort | Overlong2, // 1100 ____
+                TooShort, // 1101 ____
+                TooShort | Overlong3 | Surrogate, // 1110 ____
+                TooShort | TooLarge | TooLarge1000 | Overlong4, // 1111 ____
+            };
+            static constexpr u8 Byte1Low[16] = {
+                Carry | Overlong3 | Overlong2 | Overlong4, // ____ 0000
+                Carry | Overlong2, // ____ 0001
+                Carry, Carry,
+                Carry | TooLarge, // ____ 0100
+                Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+                Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+                Carry | TooLarge | TooLarge1000 | Surrogate, // ____ 1101
+                Carry | TooLarge | TooLarge1000, Carry | TooLarge | TooLarge1000,
+            };
+            static constexpr u8 Byte2High[16] = {
+                TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, // 0___ ____
+                TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge1000 | Overlong4, // 1000 ____
+                TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge, // 1001 ____
+                TooLong | Overlong2 | TwoConts | Surrogate | TooLarge, // 1010 ____
+                TooLong | Overlong2 | TwoConts | Surrogate | TooLarge, // 1011 ____
+                TooShort, TooShort, TooShort, TooShort, // 11__ ____
+            };
+            static constexpr u8 IncompleteMax[32] = { // a block mustn't end with the leading byte of an unfinished sequence
+                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+            };
+            const __m256i T1H = Table16(Byte1High), T1L = Table16(Byte1Low), T2H = Table16(Byte2High);
+            const __m256i LowNibble = _mm256_set1_epi8(0x0F);
+            const __m256i Max = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(IncompleteMax));
+
+            __m256i Error = _mm256_setzero_si256();
+            __m256i PreviousInput = _mm256_setzero_si256();
+            __m256i PreviousIncomplete = _mm256_setzero_si256();
+            const auto Check = [&](const __m256i Input) WMM_TARGET_AVX2 {
+                if (_mm256_movemask_epi8(Input) == 0) { // ASCII block: only an unfinished sequence of the previous block is possible
+                    Error = _mm256_or_si256(Error, PreviousIncomplete);
+                    PreviousIncomplete = _mm256_setzero_si256();
+                }
+                else {
+                    const __m256i Prev1 = Previous<1>(Input, PreviousInput);
+                    const __m256i SpecialCases = _mm256_and_si256(
+                        _mm256_and_si256(
+                            Lookup16(_mm256_and_si256(_mm256_srli_epi16(Prev1, 4), LowNibble), T1H),
+                            Lookup16(_mm256_and_si256(Prev1, LowNibble), T1L)),
+                        Lookup16(_mm256_and_si256(_mm256_srli_epi16(Input, 4), LowNibble), T2H));
+                    const __m256i IsThirdByte = _mm256_subs_epu8(Previous<2>(Input, PreviousInput), _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80))); // >= 0x80 only for 111_ ____
+                    const __m256i IsFourthByte = _mm256_subs_epu8(Previous<3>(Input, PreviousInput), _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80))); // >= 0x80 only for 1111 ____
+                    const __m256i Must23As80 = _mm256_and_si256(_mm256_or_si256(IsThirdByte, IsFourthByte), _mm256_set1_epi8(static_cast<char>(0x80)));
+                    Error = _mm256_or_si256(Error, _mm256_xor_si256(Must23As80, SpecialCases));
+                    PreviousIncomplete = _mm256_subs_epu8(Input, Max);
+                }
+                PreviousInput = Input;
+            };
+            qsizetype i = 0;
+            for (; i + 32 <= n; i += 32) { Check(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i))); }
+            if (i < n) { // the tail is padded with ASCII NUL
+                alignas(32) u8 Tail[32] = {};
+                std::memcpy(Tail, s + i, n - i);
+                Check(_mm256_load_si256(reinterpret_cast<const __m256i*>(Tail)));
+            }
+            Error = _mm256_or_si256(Error, PreviousIncomplete);
+            return _mm256_testz_si256(Error, Error) != 0;
+        }
+
+        WMM_TARGET_AVX2 char16_t* UTF8ToUTF16AVX2(const u8* const s, const qsizetype n, char16_t* d) noexcept { // the input must be valid
+            qsizetype i = 0;
+            while (i + 32 <= n) {
+                const __m256i Input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+                const unsigned Mask = static_cast<unsigned>(_mm256_movemask_epi8(Input));
+                if (Mask == 0) { // 32 ASCII characters: zero-extend to 16 bits
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(Input)));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(Input, 1)));
+                    i += 32;
+                    d += 32;
+                    continue;
+                }
+                const int ASCIICount = std::countr_zero(Mask);
+                for (int k = 0; k < ASCIICount; ++k) { d[k] = s[i + k]; }
+                i += ASCIICount;
+                d += ASCIICount;
+                while (i < n && s[i] >= 0x80) { i += DecodeSequence(s, i, d); } // a run of non-ASCII characters, e.g., CJK
+            }
+            return UTF8ToUTF16Scalar(s + i, n - i, d);
+        }
+
+        WMM_TARGET_AVX2 char* UTF16ToUTF8AVX2(const char16_t* const s, const qsizetype n, char* d) noexcept { // nullptr if there's a lone surrogate
+            qsizetype i = 0;
+            const __m256i NonASCII = _mm256_set1_epi16(static_cast<short>(0xFF80));
+            while (i + 16 <= n) {
+                const __m256i Input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+                if (_mm256_testz_si256(Input, NonASCII)) { // 16 ASCII characters: narrow to 8 bits
+                    const __m256i Packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(Input, Input), 0b1000); // packus works in each 128-bit lane
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm256_castsi256_si128(Packed));
+                    i += 16;
+                    d += 16;
+                    continue;
+                }
+                do {
+                    if (s[i] < 0x80) { *d++ = static_cast<char>(s[i++]); }
+                    else {
+                        const qsizetype Count = EncodeCodePoint(s, i, n, d);
+                        if (Count == 0) { return nullptr; }
+                        i += Count;
+                    }
+                } while (i < n && s[i] >= 0x80);
+            }
+            return UTF16ToUTF8Scalar(s + i, n - i, d);
+        }
+
+        bool DetectAVX2() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int Info[4];
+            __cpuid(Info, 0);
+            if (Info[0] < 7) { return false; }
+            __cpuid(Info, 1);
+            if ((Info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0b110) != 0b110) { return false; } // OSXSAVE, and the OS saves the YMM registers
+            __cpuidex(Info, 7, 0);
+            return (Info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+    }
+
+    bool UTFConverter::HasAVX2() noexcept {
+#ifdef WMM_X86
+        static const bool Supported = DetectAVX2();
+        return Supported;
+#else
+        return false;
+#endif
+    }
+
+    qsizetype UTFConverter::ASCIIPrefixLength(const QByteArrayView Data) noexcept {
+        const auto* const s = reinterpret_cast<const u8*>(Data.data());
+#ifdef WMM_X86
+        if (HasAVX2()) { return ASCIIPrefixLengthAVX2(s, Data.size()); }
+#endif
+        return ASCIIPrefixLengthScalar(s, Data.size());
+    }
+
+    bool UTFConverter::IsValidUTF8(const QByteArrayView Data) noexcept {
+        const auto* const s = reinterpret_cast<const u8*>(Data.data());
+#ifdef WMM_X86
+        if (HasAVX2()) { return IsValidUTF8AVX2(s, Data.size()); }
+#endif
+        return IsValidUTF8Scalar(s, Data.size());
+    }
+
+    QString UTFConverter::ToUTF16(const QByteArrayView UTF8) {
+        if (UTF8.startsWith("\xEF\xBB\xBF") || IsValidUTF8(UTF8) == false) { return QString::fromUtf8(UTF8); } // let Qt handle the BOM and the replacement of invalid sequences
+        QString Result(UTF8.size(), Qt::Uninitialized); // UTF-16 never has more code units than the bytes of UTF-8
+        const auto* const s = reinterpret_cast<const u8*>(UTF8.data());
+        auto* const d = reinterpret_cast<char16_t*>(Result.data());
+#ifdef WMM_X86
+        const char16_t* const End = HasAVX2() ? UTF8ToUTF16AVX2(s, UTF8.size(), d) : UTF8ToUTF16Scalar(s, UTF8.size(), d);
+#else
+        const char16_t* const End = UTF8ToUTF16Scalar(s, UTF8.size(), d);
+#endif
+        Result.truncate(End - d);
+        return Result;
+    }
+
+    QByteArray UTFConverter::ToUTF8(const QStringView UTF16) {
+        QByteArray Result(UTF16.size() * 3, Qt::Uninitialized); // each code unit takes at most 3 bytes; a surrogate pair takes 4 bytes
+        const auto* const s = reinterpret_cast<const char16_t*>(UTF16.utf16());
+        char* const d = Result.data();
+#ifdef WMM_X86
+        const char* const End = HasAVX2() ? UTF16ToUTF8AVX2(s, UTF16.size(), d) : UTF16ToUTF8Scalar(s, UTF16.size(), d);
+#else
+        const char* const End = UTF16ToUTF8Scalar(s, UTF16.size(), d);
+#endif
+        if (End == nullptr) { return UTF16.toUtf8(); } // let Qt handle the lone surrogates
+        Result.truncate(End - d);
+        return Result;
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef WRITING_MATERIALS_MANAGER_UTFCONVERTER_H
+#define WRITING_MATERIALS_MANAGER_UTFCONVERTER_H
+
+#include <QByteArray>
+#include <QString>
+
+namespace WritingMaterialsManager {
+    /**
+     * UTF-8 validation and UTF-8 <-> UTF-16 conversion for large text. ASCII runs are processed 32 bytes at a time with AVX2 (if the CPU supports it) or 8 bytes at a time otherwise.
+     * The results are the same as the corresponding Qt functions. Input which isn't well-formed (rare in practice) is delegated to Qt, so is its replacement behavior.
+     */
+    class UTFConverter {
+    public:
+        static bool HasAVX2() noexcept; // detected at runtime once
+
+        static qsizetype ASCIIPrefixLength(const QByteArrayView Data) noexcept;
+        static bool IsValidUTF8(const QByteArrayView Data) noexcept; // overlong forms, surrogates, code points beyond U+10FFFF and truncated sequences are invalid
+
+        static QString ToUTF16(const QByteArrayView UTF8); // the same as QString::fromUtf8()
+        static QByteArray ToUTF8(const QStringView UTF16); // the same as QString::toUtf8()
+    };
+}
+
+#endif //WRITING_MATERIALS_MANAGER_UTFCONVERTER_H
@@ -1,5 +1,7 @@
 #include "predefined.h"
 
+#include <optional>
+
 #pragma warning(push, 0) // begin the suppression of all warnings for Qt libraries
 
 #include <QApplication>
@@ -9,6 +11,7 @@
 
 #include <QStyle>
 #include <QStyleFactory>
+#include <QTimer>
 
 #pragma warning(pop) // end suppression
 
@@ -16,6 +19,7 @@
 #include "DataSourceManagerWindow.h"
 #include "EditorWindow.h"
 #include "ExtraFunctionWindow.h"
+#include "StartupProfiler.h"
 
 // tests of this project wmm
 
@@ -26,8 +30,13 @@ using namespace std::chrono_literals;
 using namespace WritingMaterialsManager;
 
 int main(int argc, char* argv[]) {
+    StartupProfiler::Mark("main");
+    std::optional<StartupProfiler::Phase> Phase;
+    Phase.emplace("QApplication");
     QApplication App(argc, argv); // <only 1 instance> manages the Widgets app's control flow and main settings
+    QObject::connect(&App, &QApplication::aboutToQuit, []() { StartupProfiler::WriteTrace(); }); // the phases in the background may end after the startup
 
+    Phase.emplace("translator");
     QTranslator Translator; // internationalization support for text output
     const QStringList UILanguages = QLocale::system().uiLanguages(); // A list of locale names for translation in preference order
     for (const QString& Locale: UILanguages) {
@@ -38,6 +47,7 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    Phase.emplace("palette");
     {// default theme
         qApp->setStyle(QStyleFactory::create("windows"));
 
@@ -62,10 +72,18 @@ int main(int argc, char* argv[]) {
 
     //auto DataSourceManagerWnd = new class DataSourceManagerWindow;
     //DataSourceManagerWnd->showMaximized();
+    Phase.emplace("EditorWindow");
     auto EditorWnd = new class EditorWindow;
     EditorWnd->showMaximized();
+    Phase.emplace("ExtraFunctionWindow");
     auto ExtFnWnd = new class ExtraFunctionWindow;
     ExtFnWnd->showMaximized();
+    Phase.reset();
+
+    QTimer::singleShot(0, &App, []() { // the windows have been shown when the event loop becomes idle for the 1st time
+        StartupProfiler::Mark("event loop");
+        StartupProfiler::PrintSummary();
+    });
 
     return QApplication::exec(); // Enters the main event loop and waits until exit() is called
 }
@@ -1,19 +1,32 @@
 // std
+#include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <memory>
 #include <numbers>
 #include <random>
 #include <set>
+#include <thread>
 #include <unordered_set>
 
 // Qt
 #include <QByteArray>
 #include <QCryptographicHash>
+#include <QDateTime>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QString>
+#include <QStringDecoder>
+#include <QTextCodec>
+#include <QTimeZone>
+
+// mongocxx
+#include <bsoncxx/builder/basic/array.hpp>
+#include <bsoncxx/builder/basic/document.hpp>
+#include <bsoncxx/builder/basic/kvp.hpp>
+#include <bsoncxx/types.hpp>
 
 // googletest
 #include <gtest/gtest.h>
@@ -23,9 +36,16 @@
 
 // Modules tested
 #include "src/Algorithm.h"
+#include "src/CharsetDetector.h"
 #include "src/FileSystemAccessor.h"
 #include "src/JSONFormatter.h"
+#include "src/JSONLinesIndex.h"
 #include "src/MongoDBAccessor.h"
+#include "src/PieceTable.h"
+#include "src/QtTreeModel.h"
+#include "src/StartupProfiler.h"
+#include "src/Transcoder.h"
+#include "src/UTFConverter.h"
 
 constexpr auto next_int = [](const auto a, const auto b) noexcept -> auto {
     return tiny_random::number::integer(a, b);
@@ -250,6 +270,112 @@ TEST(Algorithm, CaseInsensitiveComparator) {
     }
 }
 
+TEST(Algorithm, CaseFolding) {
+    namespace wmm = WritingMaterialsManager;
+    using wmm::CaseFolding;
+
+    for (char32_t c = 0; c <= QChar::LastValidCodePoint; ++c) { // the table and the range checks agree with Qt on every code point
+        if (QChar::isSurrogate(c)) { continue; }
+        ASSERT_EQ(CaseFolding::Fold(c), QChar::toCaseFolded(c)) << "U+" << std::hex << static_cast<uint32_t>(c);
+        if (CaseFolding::NoFoldingNeeded(c)) { ASSERT_EQ(QChar::toCaseFolded(c), c); }
+    }
+
+    constexpr size_t n = 1e5; // test count
+    constexpr size_t lmax = 200; // max length of test strings
+
+    static constexpr wmm::CaseInsensitiveHasher hasher;
+    static constexpr wmm::CaseInsensitiveStringComparator comparator;
+    auto next_mixed_str = []() { // mostly CJK with some Latin, Greek, Cyrillic, fullwidth letters and supplementary ideographs
+        constexpr char32_t ranges[][2] = { { 0x4E00, 0x9FFF }, { 0x4E00, 0x9FFF }, { 0x3000, 0x30FF }, { U'A', U'z' }, { 0xC0, 0x17F }, { 0x391, 0x3C9 }, { 0x400, 0x4FF }, { 0xFF21, 0xFF5A }, { 0x20000, 0x2A6DF }, };
+        QString s;
+        const size_t l = next_int(0ull, lmax);
+        for (size_t i = 0; i < l; ++i) {
+            const auto& r = ranges[next_int(0ull, std::size(ranges) - 1)];
+            const char32_t c = static_cast<char32_t>(next_int(static_cast<uint32_t>(r[0]), static_cast<uint32_t>(r[1])));
+            s.append(QString::fromUcs4(&c, 1));
+        }
+        return s;
+    };
+    for (size_t i = 0; i < n; ++i) {
+        const QString s = next_mixed_str();
+        const QString t = next_int(0, 1) ? s.toUpper() : s.toLower();
+        const QString u = next_mixed_str();
+        const bool folded_eq = s.toCaseFolded() == t.toCaseFolded();
+        EXPECT_EQ(comparator(s, t), folded_eq);
+        EXPECT_EQ(comparator(QStringView(s), QStringView(t)), folded_eq);
+        if (folded_eq) { EXPECT_EQ(hasher(s), hasher(t)); EXPECT_EQ(hasher(QStringView(s)), hasher(t)); }
+        const bool expected = s.toCaseFolded() == u.toCaseFolded();
+        EXPECT_EQ(comparator(s, u), expected);
+        if (expected == false) { EXPECT_NE(hasher(s), hasher(u)); }
+
+        std::u32string folded; // the view yields exactly the folded code points
+        for (const char32_t c : CaseFolding::View(s)) { folded.push_back(c); }
+        EXPECT_EQ(QString::fromStdU32String(folded), s.toCaseFolded());
+    }
+
+    for (const auto& [upper, lower] : { std::pair<char32_t, char32_t>{ 0x10400, 0x10428 }, { 0x104B0, 0x104D8 } }) { // Deseret & Osage: both cases share the high surrogate
+        const QString s = u'a' + QString::fromUcs4(&upper, 1) + u'b', t = u'A' + QString::fromUcs4(&lower, 1) + u'B';
+        EXPECT_TRUE(comparator(s, t));
+        EXPECT_TRUE(comparator(QStringView(s), QStringView(t)));
+        EXPECT_EQ(hasher(s), hasher(t));
+        const char32_t other = upper + 1;
+        EXPECT_FALSE(comparator(s, u'a' + QString::fromUcs4(&other, 1) + u'b')); // the low surrogates differ
+    }
+}
+
+TEST(Algorithm, StaticStringMap) {
+    namespace wmm = WritingMaterialsManager;
+
+    enum class Type { A, B, C, };
+    static constexpr auto ci_map = wmm::MakeStaticStringMap<Type>({ { "JSON", Type::A }, { "MongoDB Extended JSON", Type::B }, { "txt", Type::C }, });
+    static constexpr auto cs_map = wmm::MakeStaticStringMap<Type, Qt::CaseSensitive>({ { "true", Type::A }, { "false", Type::B }, { "null", Type::C }, });
+    static_assert(ci_map.Find("json")->Value == Type::A && ci_map.Find("mongodb extended json")->Value == Type::B); // lookups are usable at compile time
+    static_assert(cs_map.Find("null")->Value == Type::C && cs_map.Find("NULL") == nullptr);
+
+    constexpr size_t n = 1e6; // test count
+
+    for (const auto& entry : ci_map) { // every key is found regardless of its case and its string type
+        const auto key = QByteArray(entry.Key.data(), entry.Key.size());
+        for (size_t i = 0; i < 100; ++i) {
+            const QByteArray k = random_case(key);
+            ASSERT_NE(ci_map.Find(k), nullptr); EXPECT_EQ(ci_map.Find(k)->Value, entry.Value);
+            ASSERT_NE(ci_map.Find(QString::fromUtf8(k)), nullptr); EXPECT_EQ(ci_map.Find(QString::fromUtf8(k))->Value, entry.Value);
+            EXPECT_EQ(ci_map.Find(QByteArrayView(k)), ci_map.Find(QStringView(QString::fromUtf8(k))));
+        }
+    }
+    for (const auto& entry : cs_map) { EXPECT_EQ(cs_map.Find(QString::fromUtf8(entry.Key.data(), entry.Key.size()).toUpper()), nullptr); }
+    for (size_t i = 0; i < n; ++i) { // absent keys are never found
+        const auto s = QByteArray::fromStdString(next_str(next_int(0ull, 24ull)));
+        bool expected = false;
+        for (const auto& entry : ci_map) { expected |= s.compare(QByteArray(entry.Key.data(), entry.Key.size()), Qt::CaseInsensitive) == 0; }
+        EXPECT_EQ(ci_map.Contains(s), expected);
+        EXPECT_EQ(ci_map.Contains(QString::fromUtf8(s) + QChar(u'中')), false); // non-ASCII keys never match
+    }
+}
+
+TEST(CharsetDetector, Detect) {
+    using cd = WritingMaterialsManager::CharsetDetector;
+
+    constexpr size_t n = 200; // test count
+    const QString common = QString::fromUtf8("的一是不了人我在有他中大上到子和你地出道也年得就那要下以可生天能而多都然自好"); // in both GB2312 and Big5
+    for (size_t i = 0; i < n; ++i) {
+        QString text = "{";
+        const size_t m = next_int(16ull, 500ull); // the detection is statistical, thus the text shouldn't be too short
+        for (size_t j = 0; j < m; ++j) { // JSON with both ASCII and CJK
+            text += "\"" + QString::fromStdString(next_str(next_int(1ull, 16ull), tiny_random::chr::ASCII_char_type::alnum)) + "\": \"";
+            const size_t l = next_int(8ull, 32ull);
+            for (size_t k = 0; k < l; ++k) { text += common[next_int(qsizetype(0), common.size() - 1)]; }
+            text += j + 1 < m ? "\", " : "\"}";
+        }
+        EXPECT_EQ(cd::Detect(text.toUtf8()), "UTF-8");
+        EXPECT_EQ(cd::Detect("\xEF\xBB\xBF" + text.toUtf8()), "UTF-8");
+        for (const char* const charset: { "GB18030", "Big5", "UTF-16LE", "UTF-16BE" }) {
+            EXPECT_EQ(cd::Detect(QTextCodec::codecForName(charset)->fromUnicode(text)), charset);
+        }
+        EXPECT_EQ(cd::Detect(QByteArray::fromStdString(next_str(next_int(0ull, 1000ull)))), "UTF-8"); // ASCII
+    }
+}
+
 TEST(FileSystemAccessor, Read) {
     using fsa = WritingMaterialsManager::FileSystemAccessor;
 
@@ -288,6 +414,10 @@ TEST(FileSystemAccessor, Read) {
         const std::shared_ptr<QFileInfo> fi = fsa::GetFileInfo(f);      // read file info
         EXPECT_TRUE(basenames.contains(fi->baseName().toULongLong()));
         EXPECT_TRUE(contents.contains(fsa::GetAllRawContents(f)));      // read file content
+        const QByteArrayView mapped = fsa::Map(f);                       // map file content
+        EXPECT_TRUE(contents.contains(QByteArray::fromRawData(mapped.data(), mapped.size())));
+        fsa::Unmap(f, mapped);
+        EXPECT_TRUE(contents.contains(fsa::GetAllMappedContents(f)));
     }
     for (size_t i = 0; i < N / 2; ++i) { // open exception test
         bool has_open_exception = false;
@@ -300,6 +430,40 @@ TEST(FileSystemAccessor, Read) {
     }
 }
 
+TEST(FileSystemAccessor, Write) {
+    using fsa = WritingMaterialsManager::FileSystemAccessor;
+    using bfw = WritingMaterialsManager::BufferedFileWriter;
+
+    std::filesystem::create_directories("test/FileSystemAccessor");
+    const QString pathname = QString::fromStdString(std::filesystem::absolute(std::filesystem::path("test/FileSystemAccessor/write.txt")).string());
+
+    constexpr size_t n = 100; // test count
+    QByteArray previous;
+    for (size_t i = 0; i < n; ++i) {
+        const qsizetype buffer_size = next_int(qsizetype(1), qsizetype(1) << 16);
+        QByteArray content;
+        { // pieces of random sizes, some of which are larger than the buffer
+            bfw writer(pathname, buffer_size);
+            const size_t pieces = next_int(0ull, 100ull);
+            for (size_t j = 0; j < pieces; ++j) {
+                const QByteArray piece = QByteArray::fromStdString(next_str(next_int(0ull, 2ull * buffer_size)));
+                if (next_int(0, 1) == 0) { writer.Write(piece); }
+                else { for (const char c: piece) { writer.Put(c); } } // as a RapidJSON output stream
+                content.append(piece);
+            }
+            EXPECT_EQ(writer.GetBytesWritten(), content.size());
+            if (i > 0 && next_int(0, 3) == 0) { // abandoned: the file is untouched
+                if (next_int(0, 1) == 0) { writer.Cancel(); }
+                content = previous;
+            }
+            else { writer.Commit(); }
+        }
+        EXPECT_EQ(fsa::GetAllRawContents(fsa::Open(pathname)), content);
+        previous = content;
+    }
+    std::filesystem::remove(std::filesystem::path(pathname.toStdString()));
+}
+
 TEST(JSONFormatter, Default) {
     using fsa = WritingMaterialsManager::FileSystemAccessor;
 
@@ -331,6 +495,7 @@ TEST(JSONFormatter, Default) {
         auto content = fsa::GetAllRawContents(f);
         auto json = QString::fromUtf8(content);
         formatter.Format(json);
+        EXPECT_EQ(json, formatter.Format(QByteArrayView(fsa::GetAllMappedContents(f)))); // formatting UTF-8 directly yields the same result
         const auto g = fsa::Open(QString::fromStdString(pwd) + '/' + std::to_string(basename).c_str() + "F.json", QIODevice::WriteOnly);
         g->write(json.toStdString().c_str());
         const auto h = fsa::Open(QString::fromStdString(pwd) + '/' + std::to_string(basename).c_str() + "F.json", QIODevice::ReadOnly);
@@ -349,6 +514,35 @@ TEST(JSONFormatter, Default) {
     }
 }
 
+TEST(JSONLinesIndex, Record) {
+    using jli = WritingMaterialsManager::JSONLinesIndex;
+
+    constexpr size_t n = 100; // test count
+    for (size_t i = 0; i < n; ++i) {
+        std::vector<QByteArray> records;
+        QByteArray text;
+        const size_t l = next_int(0ull, 10000ull);
+        for (size_t j = 0; j < l; ++j) {
+            switch (next_int(0, 3)) {
+            case 0: text += QByteArray(next_int(0, 3), ' ') + '\n'; break; // blank line
+            case 1: text += "\r\n"; break;
+            default:
+                records.emplace_back(QByteArray::fromStdString("{\"" + next_str(next_int(0ull, 40ull), tiny_random::chr::ASCII_char_type::alnum) + "\":" + std::to_string(j) + '}'));
+                text += QByteArray(next_int(0, 2), '\t') + records.back() + QByteArray(next_int(0, 2), ' ') + (next_int(0, 1) == 0 ? "\n" : "\r\n");
+                break;
+            }
+        }
+        if (next_int(0, 1) == 0 && text.endsWith('\n')) { text.chop(1); } // the last line may have no newline
+        const jli index(text);
+        ASSERT_EQ(index.Count(), static_cast<qsizetype>(records.size()));
+        for (size_t j = 0; j < records.size(); ++j) {
+            EXPECT_EQ(index.Record(j), records[j]);
+            EXPECT_TRUE(QByteArrayView(text).sliced(index.Offset(j)).trimmed().startsWith(records[j])); // the offset is the beginning of the line
+        }
+        EXPECT_TRUE(index.Record(records.size()).isEmpty());
+    }
+}
+
 TEST(MongoDBAccessor, BasicInfo) {
     WritingMaterialsManager::MongoDBAccessor mongoa;
     QJsonParseError e;
@@ -388,4 +582,250 @@ TEST(MongoDBAccessor, BasicInfo) {
             for (const auto key : keys) { EXPECT_TRUE(unwrapped_subnode.contains(key)); }
         }
     }
+    { // the same information built from BSON directly
+        const auto tree = mongoa.GetDBsAndCollsTree();
+        const auto root = QJsonDocument::fromJson(mongoa.GetDBsAndCollsInfo()).array();
+        ASSERT_EQ(tree->ChildCount(), root.size());
+        for (int i = 0; i < root.size(); ++i) {
+            const auto db = tree->Child(i);
+            const auto colls = db->Child(db->ChildCount() - 1);
+            EXPECT_EQ(colls->Data(0).toString(), QStringLiteral("Collections"));
+            EXPECT_EQ(colls->ChildCount(), root[i].toObject()["Collections"].toArray().size());
+        }
+    }
+}
+
+TEST(MongoDBAccessor, BuildTree) {
+    using mdba = WritingMaterialsManager::MongoDBAccessor;
+    using namespace bsoncxx::builder::basic;
+
+    const bsoncxx::oid id;
+    const uint8_t bytes[] = { 1, 2, 3, };
+    const auto doc = make_document(
+        kvp("_id", id),
+        kvp("name", "wmm"),
+        kvp("count", 42),
+        kvp("size", int64_t{ 1 } << 40),
+        kvp("ratio", 0.5),
+        kvp("none", bsoncxx::types::b_null{}),
+        kvp("created", bsoncxx::types::b_date{ std::chrono::milliseconds{ 1700000000123 } }),
+        kvp("price", bsoncxx::types::b_decimal128{ bsoncxx::decimal128("12.34") }),
+        kvp("data", bsoncxx::types::b_binary{ bsoncxx::binary_sub_type::k_binary, sizeof(bytes), bytes }),
+        kvp("tags", make_array("a", make_document(kvp("b", true))))
+    );
+    WritingMaterialsManager::QtTreeModel::Node top({ QVariant() });
+    mdba::BuildTree(&top, doc.view());
+    ASSERT_EQ(top.Data(1), QVariant(QByteArray("<Object>")));
+    ASSERT_EQ(top.ChildCount(), 10);
+    const auto value = [&](const int i) { return top.Child(i)->Data(1); };
+    EXPECT_EQ(top.Child(0)->Data(0).toString(), QStringLiteral("_id"));
+    EXPECT_EQ(value(0).value<mdba::ObjectID>().ToString(), QString::fromStdString(id.to_string())); // the types are kept
+    EXPECT_EQ(value(0).toString(), QString::fromStdString(id.to_string())); // and shown as strings
+    EXPECT_EQ(value(1), QVariant(QStringLiteral("wmm")));
+    EXPECT_EQ(value(2).typeId(), QMetaType::Int);
+    EXPECT_EQ(value(2).toInt(), 42);
+    EXPECT_EQ(value(3).typeId(), QMetaType::LongLong);
+    EXPECT_EQ(value(3).toLongLong(), qint64{ 1 } << 40);
+    EXPECT_EQ(value(4), QVariant(0.5));
+    EXPECT_EQ(value(5).typeId(), QMetaType::Nullptr);
+    EXPECT_EQ(value(6).toDateTime(), QDateTime::fromMSecsSinceEpoch(1700000000123, QTimeZone::utc())); // the same instant in any time spec
+    EXPECT_EQ(value(7).value<mdba::Decimal128>().ToString(), QStringLiteral("12.34"));
+    EXPECT_EQ(value(8).value<mdba::Binary>().Bytes, QByteArray("\x01\x02\x03"));
+    const auto tags = top.Child(9);
+    EXPECT_EQ(tags->Data(1), QVariant(QByteArray("<Array>")));
+    ASSERT_EQ(tags->ChildCount(), 2);
+    EXPECT_EQ(tags->Child(0)->Data(0), QVariant(0)); // the indices of an array
+    EXPECT_EQ(tags->Child(0)->Data(1), QVariant(QStringLiteral("a")));
+    ASSERT_EQ(tags->Child(1)->ChildCount(), 1);
+    EXPECT_EQ(tags->Child(1)->Child(0)->Data(0), QVariant(QStringLiteral("b")));
+    EXPECT_EQ(tags->Child(1)->Child(0)->Data(1), QVariant(true));
+}
+
+TEST(MongoDBAccessor, Concurrency) {
+    using mdba = WritingMaterialsManager::MongoDBAccessor;
+
+    const QByteArray expected = mdba().GetCollectionsInformation("admin");
+    mdba shared(mdba::LocalMongoDBURI, { .MinSize = 1, .MaxSize = 4 }); // fewer clients than threads: the others wait for a client
+    std::vector<std::thread> threads;
+    std::atomic<int> matched = 0;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 10; ++j) {
+                if (shared.GetCollectionsInformation("admin") == expected) { ++matched; }
+            }
+        });
+    }
+    for (auto& t: threads) { t.join(); }
+    EXPECT_EQ(matched, 80);
+}
+
+TEST(PieceTable, Edit) {
+    using pt = WritingMaterialsManager::PieceTable;
+
+    constexpr size_t n = 100; // test count
+    for (size_t i = 0; i < n; ++i) {
+        std::string ref = next_str(next_int(0ull, 200ull), tiny_random::chr::ASCII_char_type::alnum); // the expected text
+        for (char& c: ref) { if (next_int(0, 7) == 0) { c = '\n'; } }
+        const std::string original = ref; // not copied by the table
+        pt table(QByteArrayView(original.data(), original.size()));
+        for (size_t j = 0; j < 100; ++j) {
+            if (next_int(0, 1) == 0) { // insert, often at the end (i.e., typing)
+                std::string s = next_str(next_int(1ull, 5ull), tiny_random::chr::ASCII_char_type::alnum);
+                if (next_int(0, 2) == 0) { s += '\n'; }
+                const size_t offset = next_int(0, 2) == 0 ? ref.size() : next_int(0ull, ref.size());
+                ref.insert(offset, s);
+                table.Insert(offset, QByteArrayView(s.data(), s.size()));
+            }
+            else if (ref.empty() == false) {
+                const size_t offset = next_int(0ull, ref.size() - 1);
+                const size_t length = std::min(next_int(0ull, 5ull), ref.size() - offset);
+                ref.erase(offset, length);
+                table.Remove(offset, length);
+            }
+            ASSERT_EQ(table.Size(), static_cast<qsizetype>(ref.size()));
+            ASSERT_EQ(table.Text(), QByteArray::fromStdString(ref));
+            std::vector<qsizetype> starts{ 0 }; // of the lines
+            for (size_t k = 0; k < ref.size(); ++k) { if (ref[k] == '\n') { starts.emplace_back(k + 1); } }
+            ASSERT_EQ(table.LineCount(), static_cast<qsizetype>(starts.size()));
+            for (size_t k = 0; k < starts.size(); ++k) {
+                EXPECT_EQ(table.LineStart(k), starts[k]);
+                const qsizetype end = k + 1 < starts.size() ? starts[k + 1] - 1 : ref.size();
+                EXPECT_EQ(table.Line(k), QByteArray::fromStdString(ref.substr(starts[k], end - starts[k])));
+            }
+            for (size_t k = 0; k < ref.size(); ++k) { EXPECT_EQ(table.LineOf(k), std::upper_bound(starts.begin(), starts.end(), static_cast<qsizetype>(k)) - starts.begin() - 1); }
+        }
+    }
+}
+
+TEST(StartupProfiler, Trace) {
+    using sp = WritingMaterialsManager::StartupProfiler;
+
+    std::filesystem::create_directories("test/StartupProfiler");
+    const QString pathname = QString::fromStdString(std::filesystem::absolute(std::filesystem::path("test/StartupProfiler/trace.json")).string());
+
+    sp::Clear();
+    const qint64 start = sp::Now();
+    sp::Record("outer", start, start + 3000000);
+    sp::Record("inner", start + 1000000, start + 2000000);
+    std::thread([]() { sp::Record("worker", sp::Now(), sp::Now()); }).join();
+    sp::Record("instant", start + 4000000, -1);
+    EXPECT_LE(start, sp::Now()); // monotonic
+    sp::WriteTrace(pathname);
+
+    using fsa = WritingMaterialsManager::FileSystemAccessor;
+    const QJsonObject trace = QJsonDocument::fromJson(fsa::GetAllRawContents(fsa::Open(pathname))).object();
+    const QJsonArray events = trace["traceEvents"].toArray();
+    ASSERT_EQ(events.size(), 4);
+    EXPECT_EQ(events[0].toObject()["name"].toString(), "outer");
+    EXPECT_EQ(events[0].toObject()["ph"].toString(), "X");
+    EXPECT_DOUBLE_EQ(events[0].toObject()["ts"].toDouble(), start / 1e3); // in μs
+    EXPECT_DOUBLE_EQ(events[0].toObject()["dur"].toDouble(), 3000.0);
+    EXPECT_EQ(events[1].toObject()["tid"].toInt(), events[0].toObject()["tid"].toInt());
+    EXPECT_NE(events[2].toObject()["tid"].toInt(), events[0].toObject()["tid"].toInt());
+    EXPECT_EQ(events[3].toObject()["ph"].toString(), "i");
+    EXPECT_FALSE(events[3].toObject().contains("dur"));
+    sp::Clear();
+    std::filesystem::remove(std::filesystem::path(pathname.toStdString()));
+}
+
+TEST(Transcoder, Decode) {
+    using tc = WritingMaterialsManager::Transcoder;
+
+    constexpr size_t n = 50; // test count
+    const QString common = QString::fromUtf8("的一是不了人我在有他中大上到子和你地出道也年得就那要下以可生天能而多都然自好"); // in both GB2312 and Big5
+    const QString supplementary = QString::fromUtf8("😀𠀀𪚥"); // surrogate pairs in UTF-16, 4-byte sequences in GB18030
+    for (size_t i = 0; i < n; ++i) {
+        QString text;
+        const size_t l = next_int(0ull, 100000ull);
+        for (size_t j = 0; j < l; ++j) { // mixed ASCII and CJK
+            switch (next_int(0, 3)) {
+            case 0: text += QString::fromStdString(next_str(next_int(1ull, 8ull))); break;
+            case 1: text += common[next_int(qsizetype(0), common.size() - 1)]; break;
+            case 2: text += supplementary.mid(next_int(0, 2) * 2, 2); break;
+            default: text += ", "; break;
+            }
+        }
+        const int threads = next_int(1, 16);
+        const qsizetype min_chunk_size = next_int(qsizetype(1), qsizetype(64) << 10);
+        for (const char* const charset: { "GB18030", "UTF-16LE", "UTF-16BE", "UTF-32LE", "UTF-8", "ISO-8859-1" }) {
+            QTextCodec* const codec = QTextCodec::codecForName(charset);
+            const QByteArray encoded = codec->fromUnicode(text);
+            const std::unique_ptr<QTextDecoder> decoder(codec->makeDecoder());
+            EXPECT_EQ(tc::Decode(encoded, charset, threads, min_chunk_size), decoder->toUnicode(encoded)) << charset;
+        }
+        const QByteArray big5 = QTextCodec::codecForName("Big5")->fromUnicode(text);
+        EXPECT_EQ(tc::Decode(big5, "Big5", threads, min_chunk_size), QTextCodec::codecForName("Big5")->toUnicode(big5));
+        const QByteArray utf16 = QByteArray("\xFF\xFE", 2) + QTextCodec::codecForName("UTF-16LE")->fromUnicode(text); // with BOM
+        EXPECT_EQ(tc::Decode(utf16, "UTF-16", threads, min_chunk_size), text);
+    }
+
+    // boundaries
+    const QByteArray data = QTextCodec::codecForName("UTF-16LE")->fromUnicode(QString(supplementary).repeated(10000));
+    for (const auto offset: tc::Split(data, tc::BoundaryRule::UTF16LE, 64)) {
+        EXPECT_EQ(offset % 4, 0); // never inside a surrogate pair
+    }
+}
+
+static QString random_UTF_text(const size_t l) { // ASCII runs mixed with characters of 2, 3 and 4 bytes in UTF-8
+    std::u32string text;
+    for (size_t i = 0; i < l; ++i) {
+        switch (next_int(0, 4)) {
+        case 0: for (const auto c: next_str(next_int(1ull, 64ull))) { text.push_back(c); } break;
+        case 1: text.push_back(next_int(0x80u, 0x7FFu)); break;
+        case 2: text.push_back(next_int(0x4E00u, 0x9FFFu)); break;
+        case 3: text.push_back(next_int(0xE000u, 0xFEFEu)); break; // no U+FEFF, which fromUtf8() strips as a BOM at the beginning, and no noncharacters U+FFFE & U+FFFF
+        default: text.push_back(next_int(0x10000u, 0x10FFFFu)); break;
+        }
+    }
+    return QString::fromStdU32String(text);
+}
+
+TEST(UTFConverter, Convert) {
+    using uc = WritingMaterialsManager::UTFConverter;
+
+    constexpr size_t n = 1000; // test count
+    for (size_t i = 0; i < n; ++i) {
+        const QString text = random_UTF_text(next_int(0ull, 1000ull));
+        const QByteArray UTF8 = text.toUtf8();
+        EXPECT_TRUE(uc::IsValidUTF8(UTF8));
+        EXPECT_EQ(uc::ToUTF16(UTF8), text);
+        EXPECT_EQ(uc::ToUTF8(text), UTF8);
+
+        // ill-formed input
+        QByteArray broken = UTF8 + "\xE4\xB8"; // truncated
+        if (UTF8.isEmpty() == false) { broken[next_int(qsizetype(0), UTF8.size() - 1)] = static_cast<char>(next_int(0x80, 0xFF)); }
+        for (const auto& bytes: { broken, broken.chopped(2) }) {
+            QStringDecoder decoder(QStringConverter::Utf8, QStringConverter::Flag::Stateless);
+            const QString decoded = decoder.decode(bytes);
+            EXPECT_EQ(uc::IsValidUTF8(bytes), decoder.hasError() == false) << bytes.toHex().constData();
+            EXPECT_EQ(uc::ToUTF16(bytes), QString::fromUtf8(bytes));
+        }
+        QString lone_surrogate = text;
+        lone_surrogate.insert(next_int(qsizetype(0), text.size()), QChar(static_cast<char16_t>(next_int(0xD800, 0xDFFF))));
+        EXPECT_EQ(uc::ToUTF8(lone_surrogate), lone_surrogate.toUtf8());
+    }
+}
+
+TEST(UTFConverter, DISABLED_Benchmark) { // microbenchmarks against Qt, run by --gtest_also_run_disabled_tests; the throughputs (MiB/s) are recorded in the XML or JSON report rather than printed
+    using uc = WritingMaterialsManager::UTFConverter;
+
+    const QString text = random_UTF_text(1 << 20);
+    const QByteArray UTF8 = text.toUtf8();
+    const QByteArray ASCII(64 << 20, 'a');
+    const auto measure = [](const char* const name, const qsizetype size, const auto& f) {
+        constexpr int rounds = 10;
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i) { f(); }
+        const std::chrono::duration<double> t = std::chrono::steady_clock::now() - t0;
+        testing::Test::RecordProperty(name, std::to_string(size * rounds / t.count() / (1 << 20)));
+    };
+    testing::Test::RecordProperty("AVX2", uc::HasAVX2() ? "yes" : "no");
+    measure("UTFConverter_IsValidUTF8", UTF8.size(), [&UTF8]() { EXPECT_TRUE(uc::IsValidUTF8(UTF8)); });
+    measure("QUtf8StringView_isValidUtf8", UTF8.size(), [&UTF8]() { EXPECT_TRUE(QUtf8StringView(UTF8).isValidUtf8()); });
+    measure("UTFConverter_ToUTF16", UTF8.size(), [&UTF8]() { EXPECT_FALSE(uc::ToUTF16(UTF8).isEmpty()); });
+    measure("QString_fromUtf8", UTF8.size(), [&UTF8]() { EXPECT_FALSE(QString::fromUtf8(UTF8).isEmpty()); });
+    measure("UTFConverter_ToUTF16_ASCII", ASCII.size(), [&ASCII]() { EXPECT_FALSE(uc::ToUTF16(ASCII).isEmpty()); });
+    measure("QString_fromUtf8_ASCII", ASCII.size(), [&ASCII]() { EXPECT_FALSE(QString::fromUtf8(ASCII).isEmpty()); });
+    measure("UTFConverter_ToUTF8", UTF8.size(), [&text]() { EXPECT_FALSE(uc::ToUTF8(text).isEmpty()); });
+    measure("QString_toUtf8", UTF8.size(), [&text]() { EXPECT_FALSE(text.toUtf8().isEmpty()); });
 }
@@ -7,8 +7,10 @@
 #include <QFile>
 #include <QJsonDocument>
 #include <QObject>
+#include <QScrollBar>
 #include <QSignalSpy>
 #include <QString>
+#include <QTemporaryDir>
 #include <QTest>
 #include <QTextCodec>
 
@@ -20,6 +22,9 @@
 #include "util.h"
 
 // files to be tested
+#include "src/FileSystemTreeModel.h"
+#include "src/JSONLinesIndex.h"
+#include "src/LargeTextView.h"
 #include "src/TreeEditor.h"
 #include "src/TreeView.h"
 
@@ -173,6 +178,58 @@ private slots:
         QCOMPARE(spy.count(), 6 * n); // click, press
     }
 
+    void TreeView__expand() {
+        namespace wmm = WritingMaterialsManager;
+
+        QByteArray large = "[0";
+        for (int i = 1; i < 2000; ++i) { large += ',' + QByteArray::number(i); }
+        large += ']';
+        wmm::QtTreeModel tree_model;
+        tree_model.FromJSON(R"({"small":[1,2,3],"large":)" + large + R"(,"deep":{"a":{"b":{"c":1}}}})");
+        const QModelIndex root = tree_model.index(0, 0);
+        const QModelIndex small = tree_model.index(0, 0, root), large_array = tree_model.index(1, 0, root), deep = tree_model.index(2, 0, root);
+        const QModelIndex a = tree_model.index(0, 0, deep), b = tree_model.index(0, 0, a);
+
+        wmm::TreeView tree_view;
+        tree_view.setModel(&tree_model);
+        tree_view.Expand(); // default policy: the large array is skipped
+        QVERIFY(tree_view.isExpanded(root) && tree_view.isExpanded(small) && tree_view.isExpanded(deep) && tree_view.isExpanded(b));
+        QVERIFY(tree_view.isExpanded(large_array) == false);
+        tree_view.collapseAll();
+        tree_view.Expand({ .MaxDepth = 2 });
+        QVERIFY(tree_view.isExpanded(root) && tree_view.isExpanded(deep));
+        QVERIFY(tree_view.isExpanded(a) == false);
+        tree_view.collapseAll();
+        tree_view.Expand({ .RowBudget = 5 }); // the 3 children of the root, then the 3 elements of "small" would exceed the budget
+        QVERIFY(tree_view.isExpanded(root));
+        QVERIFY(tree_view.isExpanded(small) == false);
+        tree_view.collapseAll();
+        tree_view.Expand(large_array, { .LargeChildCount = -1 }); // smart expand on demand
+        QVERIFY(tree_view.isExpanded(large_array));
+    }
+
+    void TreeView__fit_columns() {
+        namespace wmm = WritingMaterialsManager;
+
+        const QByteArray long_value(300, 'x'), longer_value(600, 'y');
+        QByteArray large = "[0";
+        for (int i = 1; i < 2000; ++i) { large += ",\"" + long_value + '"'; }
+        large += ",\"" + longer_value + "\"]";
+        wmm::QtTreeModel tree_model;
+        tree_model.FromJSON(R"({"key":")" + long_value + R"(","large":)" + large + '}');
+
+        wmm::TreeView tree_view;
+        tree_view.setModel(&tree_model);
+        tree_view.Expand(); // the large array is collapsed
+        tree_view.FitColumns();
+        QVERIFY(tree_view.columnWidth(1) >= tree_view.fontMetrics().horizontalAdvance(long_value));
+        QVERIFY(tree_view.columnWidth(1) < tree_view.fontMetrics().horizontalAdvance(longer_value));
+        tree_view.expand(tree_model.index(1, 0, tree_model.index(0, 0))); // widened by a sample of the children, which always includes the first ones
+        QVERIFY(tree_view.columnWidth(1) >= tree_view.fontMetrics().horizontalAdvance(long_value));
+        tree_view.FitColumns(SHRT_MAX); // the sample covers every row
+        QVERIFY(tree_view.columnWidth(1) >= tree_view.fontMetrics().horizontalAdvance(longer_value));
+    }
+
     void QtTreeModel__construct_from_JSON() {
         namespace wmm = WritingMaterialsManager;
 
@@ -191,11 +248,238 @@ private slots:
             qDebug("Tree structure constructed.");
             qDebug("Verifying the equivalence of these 2 tree structures ...");
             QVERIFY(QtTreeModel_test(tree_model, test_JSON));
+            QCOMPARE(tree_model.GetParseErrorOffset(), -1);
+            const QString test_JSON_UTF16 = QString::fromStdString(test_JSON);
+            tree_model.FromJSON(QStringView(test_JSON_UTF16)); // import JSON in UTF-16
+            QVERIFY(QtTreeModel_test(tree_model, test_JSON));
+            const QByteArray image = tree_model.ToBinary(); // binary image used by the document cache
+            wmm::QtTreeModel restored_tree_model;
+            QVERIFY(restored_tree_model.FromBinary(image));
+            QVERIFY(QtTreeModel_test(restored_tree_model, test_JSON));
+            QVERIFY(restored_tree_model.FromBinary(image.first(image.size() - 1)) == false); // corrupted
+            QVERIFY(QtTreeModel_test(restored_tree_model, test_JSON)); // unchanged
+            tree_model.FromJSON(QByteArray::fromStdString(test_JSON + ',')); // a syntax error at the end
+            QCOMPARE(tree_model.GetParseErrorOffset(), static_cast<qsizetype>(test_JSON.size()));
             qDebug("Congratulations: Reference JSON and generated JSON are equivalent, the tree model worked correctly.");
         }
         util::enable_test_info();
     }
 
+    void QtTreeModel__construct_from_UTF16_JSON() {
+        namespace wmm = WritingMaterialsManager;
+
+        wmm::QtTreeModel tree_model;
+        const QString text = QString::fromUtf16(u"{\"\u540D\u524D\": [\"\U0001F600\", \"\u00E9\\u00E9\", 1.5e3, -2], \"x\": null}"); // a BMP key, a surrogate pair and an escape
+        tree_model.FromJSON(QStringView(text));
+        QCOMPARE(tree_model.GetParseErrorOffset(), -1);
+        QVERIFY(QtTreeModel_test(tree_model, text.toStdString()));
+        const QModelIndex array = tree_model.index(0, 0, tree_model.index(0, 0));
+        QCOMPARE(tree_model.data(array.siblingAtColumn(0)).toString(), QString::fromUtf16(u"\u540D\u524D"));
+        QCOMPARE(tree_model.data(tree_model.index(0, 1, array)).toString(), QString::fromUtf16(u"\U0001F600"));
+        QCOMPARE(tree_model.data(tree_model.index(1, 1, array)).toString(), QString::fromUtf16(u"\u00E9\u00E9"));
+        const QString invalid = QString::fromUtf16(u"[\"\U0001F600\",]");
+        tree_model.FromJSON(QStringView(invalid));
+        QCOMPARE(tree_model.GetParseErrorOffset(), qsizetype(6)); // in UTF-16 code units, so the pair counts 2
+    }
+
+    void QtTreeModel__construct_from_JSON_Lines() {
+        namespace wmm = WritingMaterialsManager;
+
+        constexpr size_t n = 100; // test count
+
+        wmm::QtTreeModel tree_model;
+
+        util::disable_test_info();
+        for (size_t i = 0; i < n; ++i) {
+            QList<QByteArray> records; // each record takes 1 line
+            const size_t record_count = tiny_random::number::integer(1ull, 20ull);
+            while (records.size() < record_count) {
+                const QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromStdString(tiny_random::chr::JSON()));
+                if (doc.isNull() == false) { records.emplace_back(doc.toJson(QJsonDocument::Compact)); }
+            }
+            const qsizetype k = tiny_random::number::integer(qsizetype(0), records.size()); // the first k records are read initially, the others are appended
+            tree_model.FromJSONLines(records.first(k).join("\n\n")); // with blank lines
+            QCOMPARE(tree_model.rowCount(tree_model.index(0, 0)), static_cast<int>(k));
+            tree_model.AppendJSONLines(records.sliced(k).join('\n') + '\n');
+            QCOMPARE(tree_model.rowCount(tree_model.index(0, 0)), static_cast<int>(records.size()));
+            QVERIFY(QtTreeModel_test(tree_model, ('[' + records.join(',') + ']').toStdString()));
+            tree_model.FromJSONLines(QString::fromUtf8(records.join("\r\n"))); // in UTF-16 with CRLF
+            QVERIFY(QtTreeModel_test(tree_model, ('[' + records.join(',') + ']').toStdString()));
+            const QByteArray lines = records.join("\n");
+            tree_model.FromJSONLines(std::make_shared<const wmm::JSONLinesIndex>(lines)); // records parsed on demand
+            QCOMPARE(tree_model.rowCount(tree_model.index(0, 0)), static_cast<int>(records.size()));
+            QVERIFY(QtTreeModel_test(tree_model, ('[' + records.join(',') + ']').toStdString()));
+        }
+        util::enable_test_info();
+
+        const QByteArray empty_records = "{}\n{ }\n[\t\r]\n[ 1 ]\n{\"a\": {}}";
+        tree_model.FromJSONLines(std::make_shared<const wmm::JSONLinesIndex>(empty_records));
+        const QModelIndex lines = tree_model.index(0, 0);
+        QVERIFY(tree_model.hasChildren(tree_model.index(0, 0, lines)) == false); // judged before the records are parsed
+        QVERIFY(tree_model.hasChildren(tree_model.index(1, 0, lines)) == false);
+        QVERIFY(tree_model.hasChildren(tree_model.index(2, 0, lines)) == false);
+        QVERIFY(tree_model.hasChildren(tree_model.index(3, 0, lines)));
+        QVERIFY(tree_model.hasChildren(tree_model.index(4, 0, lines)));
+    }
+
+    void QtTreeModel__sync_text() {
+        namespace wmm = WritingMaterialsManager;
+
+        wmm::QtTreeModel tree_model;
+        QString text = R"({"a": [1, 2, {"b": "x"}], "c": true})";
+        tree_model.FromJSON(QStringView(text));
+        QVERIFY(tree_model.IndexTextSpans(text));
+        const auto edit = [&](const qsizetype position, const qsizetype removed, const QString& added) { // an edit of the text, as QTextDocument reports it
+            text.replace(position, removed, added);
+            return tree_model.SyncTextEdit(position, removed, added.size(), [&](const qsizetype start, const qsizetype length) { return text.mid(start, length); });
+        };
+
+        // text -> tree
+        QVERIFY(edit(text.indexOf(u'2'), 1, "20")); // a value
+        QVERIFY(QtTreeModel_test(tree_model, text.toStdString()));
+        QVERIFY(edit(text.indexOf("20") + 2, 0, ", 3")); // a new element
+        QVERIFY(QtTreeModel_test(tree_model, text.toStdString()));
+        const QPersistentModelIndex object = tree_model.index(3, 0, tree_model.index(0, 0, tree_model.index(0, 0)));
+        QVERIFY(edit(text.indexOf("3,") + 2, 0, "\n  ")); // spaces between the elements
+        QVERIFY(edit(text.indexOf("3,") + 1, 0, ", [") == false); // a new element in the middle of typing
+        QVERIFY(edit(text.indexOf("[,") + 1, 0, "]"));
+        QCOMPARE(object.row(), 4); // the following element is moved rather than rebuilt
+        QVERIFY(QtTreeModel_test(tree_model, text.toStdString()));
+        const qsizetype quote = text.indexOf(R"("x")") + 2;
+        QVERIFY(edit(quote, 1, "") == false); // invalid in the middle of typing
+        QVERIFY(edit(quote, 0, "y\"") == true);
+        QVERIFY(QtTreeModel_test(tree_model, text.toStdString()));
+        QVERIFY(edit(text.indexOf(R"("c")") + 1, 1, "d")); // a key
+        QVERIFY(QtTreeModel_test(tree_model, text.toStdString()));
+        QVERIFY(edit(text.size(), 0, "\n")); // spaces after the root
+        QVERIFY(QtTreeModel_test(tree_model, text.toStdString()));
+
+        // tree -> text
+        connect(&tree_model, &wmm::QtTreeModel::TextEdited, [&](const qsizetype position, const qsizetype length, const QString& added) { text.replace(position, length, added); });
+        const QModelIndex root = tree_model.index(0, 0);
+        QVERIFY(tree_model.setData(tree_model.index(1, 1, root), false));
+        QVERIFY(text.contains(R"("d": false)"));
+        QVERIFY(tree_model.setData(tree_model.index(1, 0, root), "e\"f"));
+        QVERIFY(text.contains(R"("e\"f": false)"));
+        const QModelIndex a = tree_model.index(0, 0, root);
+        QVERIFY(tree_model.setData(tree_model.index(0, 1, tree_model.index(4, 0, a)), "z"));
+        QVERIFY(text.contains(R"({"b": "z"})"));
+        QVERIFY(tree_model.setData(tree_model.index(1, 1, a), 21));
+        QVERIFY(text.contains("[1, 21, 3,"));
+        QVERIFY(tree_model.setData(tree_model.index(1, 0, a), 5) == false); // an index
+        QVERIFY(tree_model.setData(tree_model.index(0, 1, root), 0) == false); // an array
+        QVERIFY(QtTreeModel_test(tree_model, text.toStdString()));
+        QVERIFY(edit(text.indexOf("21"), 2, "22")); // the spans are still in sync
+        QVERIFY(QtTreeModel_test(tree_model, text.toStdString()));
+        QVERIFY(tree_model.setData(a, "array")); // the key of a container, whose children move with its value
+        QVERIFY(text.contains(R"("array": [1, 22, 3,)"));
+        QVERIFY(tree_model.setData(tree_model.index(1, 1, a), 23));
+        QVERIFY(text.contains(R"("array": [1, 23, 3,)"));
+        QVERIFY(tree_model.setData(tree_model.index(0, 1, tree_model.index(4, 0, a)), "w"));
+        QVERIFY(text.contains(R"({"b": "w"})"));
+        QVERIFY(QtTreeModel_test(tree_model, text.toStdString()));
+        QVERIFY(edit(text.indexOf("23"), 2, "24"));
+        QVERIFY(QtTreeModel_test(tree_model, text.toStdString()));
+    }
+
+    void QtTreeModel__set_value_from_JSON() {
+        namespace wmm = WritingMaterialsManager;
+
+        wmm::QtTreeModel tree_model;
+        tree_model.FromJSON(QByteArrayView(R"([{"name": "a", "Collections": null}, {"name": "b", "Collections": null}])")); // placeholders loaded later
+        const QModelIndex collections = tree_model.index(1, 0, tree_model.index(0, 0, tree_model.index(0, 0)));
+        QVERIFY(tree_model.SetValueFromJSON(collections, R"([{"name": "c"}, {"name": "d"}])"));
+        const std::string expected = R"([{"name": "a", "Collections": [{"name": "c"}, {"name": "d"}]}, {"name": "b", "Collections": null}])";
+        QVERIFY(QtTreeModel_test(tree_model, expected));
+        QCOMPARE(tree_model.rowCount(collections), 2);
+        QVERIFY(tree_model.SetValueFromJSON(collections, "[") == false); // invalid
+        QVERIFY(QtTreeModel_test(tree_model, expected)); // unchanged
+    }
+
+    void FileSystemTreeModel__lazy_listing() {
+        namespace wmm = WritingMaterialsManager;
+
+        QTemporaryDir root;
+        QVERIFY(root.isValid());
+        const QDir dir(root.path());
+        QVERIFY(dir.mkpath("b/c"));
+        QVERIFY(dir.mkdir("a"));
+        for (int i = 0; i < 10; ++i) {
+            QFile file(dir.filePath("f" + QString::number(i)));
+            QVERIFY(file.open(QIODevice::WriteOnly));
+        }
+
+        wmm::FileSystemTreeModel model;
+        model.SetRootPath(root.path());
+        const QModelIndex top = model.index(0, 0);
+        QCOMPARE(model.rowCount(top), 0); // nothing is listed before it's expanded
+        QVERIFY(model.canFetchMore(top));
+        QAbstractItemModelTester tester(&model);
+        model.fetchMore(top);
+        QTRY_VERIFY(model.IsListing(top) == false);
+        QCOMPARE(model.rowCount(top), 12);
+        QCOMPARE(model.index(0, 0, top).data().toString(), "a"); // directories first
+        QCOMPARE(model.index(1, 0, top).data().toString(), "b");
+        QCOMPARE(model.index(2, 0, top).data().toString(), "f0");
+        const QModelIndex b = model.index(1, 0, top);
+        model.fetchMore(b);
+        QTRY_COMPARE(model.rowCount(b), 1);
+        QCOMPARE(model.GetPath(model.index(0, 0, b)), dir.filePath("b/c"));
+
+        // the changes of a listed directory are merged, and the listed subdirectories are kept
+        QVERIFY(dir.mkdir("d"));
+        QVERIFY(QFile::remove(dir.filePath("f0")));
+        QTRY_COMPARE(model.index(2, 0, top).data().toString(), "d");
+        QCOMPARE(model.rowCount(top), 12);
+        QCOMPARE(model.rowCount(model.index(1, 0, top)), 1);
+
+        // 2 ranges removed by 1 listing, before a listed subdirectory whose rows change
+        QVERIFY(dir.mkpath("e/g"));
+        QTRY_COMPARE(model.rowCount(top), 13);
+        QCOMPARE(model.index(3, 0, top).data().toString(), "e");
+        model.fetchMore(model.index(3, 0, top));
+        QTRY_COMPARE(model.rowCount(model.index(3, 0, top)), 1);
+        QVERIFY(QDir(dir.filePath("a")).removeRecursively()); // a & d aren't adjacent
+        QVERIFY(QDir(dir.filePath("d")).removeRecursively());
+        QTRY_COMPARE(model.rowCount(top), 11);
+        const QModelIndex e = model.index(1, 0, top); // after b
+        QCOMPARE(e.data().toString(), "e");
+        const QModelIndex g = model.index(0, 0, e);
+        QCOMPARE(model.parent(g), e);
+        QCOMPARE(model.GetPath(g), dir.filePath("e/g"));
+    }
+
+    void LargeTextView__huge_line() {
+        namespace wmm = WritingMaterialsManager;
+
+        constexpr qsizetype n = 64 << 20; // 1 line of 64 MB, e.g., minified JSON
+        QByteArray text(n, 'a');
+        text.append("\xE4\xB8\xAD" "b\r\n" "c");
+        wmm::LargeTextView view;
+        view.resize(640, 480);
+        view.SetText(text);
+        view.GoToOffset(n); // shown at once, without measuring the whole line
+        QCOMPARE(view.GetCursorLine(), 0);
+        QCOMPARE(view.GetCursorOffset(), n);
+        QTest::keyClick(&view, Qt::Key_Right); // over the 3 bytes of U+4E2D
+        QCOMPARE(view.GetCursorOffset(), n + 3);
+        QTest::keyClick(&view, Qt::Key_Left);
+        QCOMPARE(view.GetCursorOffset(), n);
+        QTest::keyClick(&view, Qt::Key_End); // before CRLF
+        QCOMPARE(view.GetCursorOffset(), n + 4);
+        QTest::mouseClick(view.viewport(), Qt::LeftButton, {}, QPoint(4, 2)); // at the left margin of the 1st line
+        QCOMPARE(view.GetCursorOffset(), view.horizontalScrollBar()->value());
+        QTest::keyClick(&view, Qt::Key_End);
+        QTest::keyClick(&view, Qt::Key_Backspace);
+        QCOMPARE(view.GetCursorOffset(), n + 3);
+        QTest::keyClick(&view, Qt::Key_Backspace); // the whole sequence of U+4E2D
+        QCOMPARE(view.GetCursorOffset(), n);
+        QTest::keyClick(&view, Qt::Key_Delete); // join with the next line, CR included
+        QCOMPARE(view.GetTable().LineCount(), 1);
+        QCOMPARE(view.GetTable().Line(0), QByteArray(n, 'a') + "c");
+        QVERIFY(view.IsModified());
+    }
+
     void TreeEditor__open_JSON() {
         namespace wmm = WritingMaterialsManager;
 